@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "bytes.h"
+
+namespace gm
+{
+
+/**
+ * @brief Cache topology of the machine, in bytes	\n
+ * Starts with the compile time values from bytes.h,
+ * probe() overwrites them with what the running cpu reports:
+ * sysfs (/sys/devices/system/cpu/cpu0/cache) first, CPUID as fallback.
+ * Use cacheInfo() to get the values probed once at startup.
+ */
+struct CacheInfo
+{
+	size_t lineSize = CACHE_LINE_SIZE; //!< bytes in a cache line
+	size_t l1 = L1KiB*1024; //!< L1 data cache bytes
+	size_t l2 = CACHE_L2_SIZE*2; //!< L2 cache bytes
+	size_t l3 = CACHE_L3_SIZE*2; //!< L3 cache bytes, per socket
+
+	/** @brief bytes of the cache level we can fill,
+	 * half of it so useful values aren't thrown out
+	 * @param level 1, 2 or 3 */
+	size_t usable(int level) const {
+		switch(level){
+			case 1: return l1/2;
+			case 2: return l2/2;
+			default: return l3/2;
+		}
+	}
+
+	/** @brief n of elems in a cache line */
+	template<typename elem>
+	size_t lineElems() const {
+		size_t n = lineSize/sizeof(elem);
+		return n ? n : 1;
+	}
+
+	/** @brief aproximate minimum number of lines L1 cache has
+	 * (for this capacity)(min lines mean max associativ), see L1LINE_N */
+	size_t l1Lines() const {
+		return (l1/8)/lineSize;
+	}
+
+	/**
+	 * @brief Side of a square block of elems so nMatrices blocks fit in
+	 * the cache level, the runtime version of B3L1, B2L2...	\n
+	 * L1 blocks are a multiple of a cache line,
+	 * L2 blocks a multiple of the L1 block, L3 of the L2 block
+	 * @param level 1, 2 or 3
+	 * @param nMatrices blocks that have to fit at once
+	 */
+	template<typename elem>
+	size_t block(int level, size_t nMatrices) const {
+		size_t below = level <= 1 ? lineElems<elem>() : block<elem>(level - 1, nMatrices);
+		size_t max = (size_t)std::sqrt(usable(level)/sizeof(elem)/nMatrices);
+		size_t b = lowerMultiple(max, below);
+		return b ? b : below;
+	}
+
+	/**
+	 * @brief Reads the cache topology of the running cpu,
+	 * values it can't find keep the compile time defaults
+	 * @return false if nothing could be read
+	 */
+	bool probe(){
+		CacheInfo found;
+		found.l1 = found.l2 = found.l3 = 0;
+		if(!found.probeSysfs() && !found.probeCpuid())
+			return false;
+		lineSize = found.lineSize;
+		if(found.l1)
+			l1 = found.l1;
+		// missing levels: blocking for them falls back to the level below
+		l2 = found.l2 ? found.l2 : l1;
+		l3 = found.l3 ? found.l3 : l2;
+		return true;
+	}
+
+	/** @brief reads /sys/devices/system/cpu/cpu0/cache/index* @return false on failure */
+	bool probeSysfs(){
+		bool found = false;
+		for(int idx = 0; ; ++idx){
+			std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(idx) + "/";
+			std::ifstream fLevel(dir + "level"), fType(dir + "type"), fSize(dir + "size");
+			if(!fLevel || !fType || !fSize)
+				break;
+			int level;
+			std::string type, size;
+			if(!(fLevel >> level) || !(fType >> type) || !(fSize >> size))
+				continue;
+			if(type == "Instruction")
+				continue;
+			size_t bytes = parseSize(size);
+			if(bytes == 0)
+				continue;
+			std::ifstream fLine(dir + "coherency_line_size");
+			size_t line;
+			if(fLine >> line && isPowerOfTwo(line))
+				lineSize = line;
+			found |= set(level, bytes);
+		}
+		return found;
+	}
+
+	/**
+	 * @brief reads CPUID leaf 4 (Intel), else 0x8000001D (AMD: leaf 4 is
+	 * all zeros there though the max basic leaf is above 4)
+	 * @return false on failure
+	 */
+	bool probeCpuid(){
+#if defined(__x86_64__) || defined(__i386__)
+		if(__get_cpuid_max(0, nullptr) >= 4 && probeCpuidLeaf(4))
+			return true;
+		if(__get_cpuid_max(0x80000000, nullptr) >= 0x8000001D)
+			return probeCpuidLeaf(0x8000001D);
+		return false;
+#else
+		return false;
+#endif
+	}
+
+protected:
+#if defined(__x86_64__) || defined(__i386__)
+	/** @brief the deterministic cache parameters of leaf, 4 or 0x8000001D
+	 * (same layout) @return false if it lists no data cache */
+	bool probeCpuidLeaf(unsigned leaf){
+		unsigned eax, ebx, ecx, edx;
+		bool found = false;
+		for(unsigned sub = 0; sub < 16; ++sub){
+			__cpuid_count(leaf, sub, eax, ebx, ecx, edx);
+			unsigned type = eax & 0x1f; // 0: no more caches, 1: data, 2: instruction, 3: unified
+			if(type == 0)
+				break;
+			if(type == 2)
+				continue;
+			int level = (eax >> 5) & 0x7;
+			size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+			size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+			size_t line = (ebx & 0xfff) + 1;
+			size_t sets = (size_t)ecx + 1;
+			if(isPowerOfTwo(line))
+				lineSize = line;
+			found |= set(level, ways*partitions*line*sets);
+		}
+		return found;
+	}
+#endif
+
+	/** @brief parses sysfs sizes like "48K", "2048K", "30M" */
+	static size_t parseSize(const std::string& s){
+		size_t pos;
+		size_t n;
+		try{
+			n = std::stoul(s, &pos);
+		}catch(...){
+			return 0;
+		}
+		if(pos < s.size()){
+			switch(s[pos]){
+				case 'K': n *= 1024; break;
+				case 'M': n *= 1024*1024; break;
+				case 'G': n *= 1024*1024*1024; break;
+			}
+		}
+		return n;
+	}
+
+	bool set(int level, size_t bytes){
+		switch(level){
+			case 1: l1 = bytes; return true;
+			case 2: l2 = bytes; return true;
+			case 3: l3 = bytes; return true;
+		}
+		return false;
+	}
+};
+
+/** @brief Cache topology of this machine, probed once at startup */
+inline const CacheInfo& cacheInfo(){
+	static const CacheInfo info = []{
+		CacheInfo ci;
+		ci.probe();
+		return ci;
+	}();
+	return info;
+}
+
+namespace detail
+{
+/** @brief probes cacheInfo() during static initialization */
+static const CacheInfo& cacheInfoAtStartup_ = cacheInfo();
+}
+
+}
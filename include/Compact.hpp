@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Vec.hpp"
+#include "Dispatch.hpp"
+
+namespace gm
+{
+
+namespace detail
+{
+
+/** @brief lane indices moving the set bits of an 8 bit mask to the front */
+struct CompactLut
+{
+	alignas(32) uint32_t idx[256][8];
+
+	CompactLut(){
+		for(unsigned m = 0; m < 256; ++m){
+			unsigned k = 0;
+			for(unsigned l = 0; l < 8; ++l)
+				if(m >> l & 1)
+					idx[m][k++] = l;
+			for(; k < 8; ++k)
+				idx[m][k] = 0;
+		}
+	}
+};
+
+inline const CompactLut& compactLut(){
+	static const CompactLut lut;
+	return lut;
+}
+
+}
+
+/**
+ * @brief Moves the x[i] with !pred(x[i]) to the front, in order, see compact()	\n
+ * With 32 bytes registers, 4 and 8 bytes T go 32 bytes at a time:
+ * the keep mask picks a permutation of 8 words in a table, one shuffle
+ * packs the kept elems and the whole group is stored at the write position,
+ * which never passes the read one. Other cases store every elem and only
+ * advance the write position for kept ones, without branches.
+ */
+template<class T, size_t W, class Pred>
+GM_INLINE size_t compactW(T* x, size_t n, Pred& pred){
+	size_t i = 0, j = 0;
+	if(W >= 32 && (sizeof(T) == 4 || sizeof(T) == 8)){
+		using G = VecW<uint32_t, 32>;
+		const size_t L = 32/sizeof(T);
+		const detail::CompactLut& lut = detail::compactLut();
+		for(; i + L <= n; i += L){
+			unsigned keep = 0;
+			unroll(l, L)
+				keep |= (unsigned)!pred(x[i + l]) << l;
+			size_t kept = __builtin_popcount(keep);
+			if(sizeof(T) == 8){
+				// a double word per elem
+				unsigned k = 0;
+				unroll(l, L)
+					k |= (keep >> l & 1)*3u << 2*l;
+				keep = k;
+			}
+			G g, idx;
+			__builtin_memcpy(&g, x + i, 32);
+			__builtin_memcpy(&idx, lut.idx[keep], 32);
+			g = __builtin_shuffle(g, idx);
+			__builtin_memcpy(x + j, &g, 32);
+			j += kept;
+		}
+	}
+	for(; i < n; ++i){
+		T v = x[i];
+		x[j] = v;
+		j += !pred(v);
+	}
+	return j;
+}
+
+template<class T, class Pred> GM_TARGET_SSE2 size_t compact_sse2(T* x, size_t n, Pred& pred){ return compactW<T, 16>(x, n, pred); }
+template<class T, class Pred> GM_TARGET_AVX2 size_t compact_avx2(T* x, size_t n, Pred& pred){ return compactW<T, 32>(x, n, pred); }
+template<class T, class Pred> GM_TARGET_AVX512 size_t compact_avx512(T* x, size_t n, Pred& pred){ return compactW<T, 64>(x, n, pred); }
+
+/**
+ * @brief Removes the x[i] with pred(x[i]) in a single pass, in place,
+ * keeping the order of the others
+ * @return n of elems kept, at the front of x, the rest of x is unspecified
+ * ```cpp
+	size_t m = gm::compact(x, n, [](float v){ return v < 0; });
+ * ```
+ * pred is called once per elem, in order.
+ */
+template<class T, class Pred>
+size_t compact(T* x, size_t n, Pred pred){
+	static const auto fn = simdPick(&compact_sse2<T, Pred>, &compact_avx2<T, Pred>, &compact_avx512<T, Pred>);
+	return fn(x, n, pred);
+}
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include "bytes.h"
+
+/**
+ * Runtime SIMD width dispatch	\n
+ * Vec<T> has the width fixed at compile time (REG_SZ), hot kernels are
+ * instead written once for a width W in bytes with VecW<T, W>, always
+ * inlined into three wrappers compiled for SSE2 (16), AVX2 (32) and
+ * AVX-512 (64), and simdPick() chooses the wrapper for the running cpu.
+ * So one binary, built without -march=native, uses the widest registers
+ * of each host.
+ * ```cpp
+	template<size_t W> GM_INLINE void kernelW(double* x, size_t n){ ... }
+	GM_TARGET_SSE2 void kernel_sse2(double* x, size_t n){ kernelW<16>(x, n); }
+	GM_TARGET_AVX2 void kernel_avx2(double* x, size_t n){ kernelW<32>(x, n); }
+	GM_TARGET_AVX512 void kernel_avx512(double* x, size_t n){ kernelW<64>(x, n); }
+	void kernel(double* x, size_t n){
+		static const auto fn = gm::simdPick(kernel_sse2, kernel_avx2, kernel_avx512);
+		fn(x, n);
+	}
+ * ```
+ */
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define GM_SIMD_DISPATCH 1
+#define GM_TARGET_SSE2 __attribute__((target("sse2")))
+#define GM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define GM_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma")))
+#else
+#define GM_SIMD_DISPATCH 0
+#define GM_TARGET_SSE2
+#define GM_TARGET_AVX2
+#define GM_TARGET_AVX512
+#endif
+
+/** @brief kernels written for a width W, inlined into the GM_TARGET_ wrappers */
+#define GM_INLINE inline __attribute__((always_inline))
+
+/**
+ * @brief Defines name(params) for every T, calling nameW<T, W>(args) with
+ * the W of simd(), through the wrappers name_sse2, name_avx2, name_avx512
+ * ```cpp
+	GM_SIMD_KERNEL(T, sum, (const T* x, size_t n), (x, n))
+ * ```
+ */
+#define GM_SIMD_KERNEL(Ret, name, params, args)	\
+template<class T> GM_TARGET_SSE2 Ret name##_sse2 params { return name##W<T, 16> args; }	\
+template<class T> GM_TARGET_AVX2 Ret name##_avx2 params { return name##W<T, 32> args; }	\
+template<class T> GM_TARGET_AVX512 Ret name##_avx512 params { return name##W<T, 64> args; }	\
+template<class T> Ret name params {	\
+	static const auto fn = simdPick(&name##_sse2<T>, &name##_avx2<T>, &name##_avx512<T>);	\
+	return fn args;	\
+}
+
+namespace gm
+{
+
+/** @brief Vec of W bytes, W a template parameter, aligned to W */
+template<typename T, size_t W>
+using VecW __attribute__((vector_size(W))) = T;
+
+/** @brief Vec of W bytes only aligned as T, to load and store at any elem */
+template<typename T, size_t W>
+using VecWu __attribute__((vector_size(W), aligned(sizeof(T)))) = T;
+
+/** @brief true for the elem types a VecW can hold: arithmetic types but bool and long double */
+template<class T>
+struct isSimdElem : std::integral_constant<bool, std::is_arithmetic<T>::value
+	&& !std::is_same<T, bool>::value && !std::is_same<T, long double>::value> {};
+
+/** @brief unsigned integer as wide as T, the lanes of masks and shuffle indices of VecW<T, W> */
+template<class T>
+using LaneInt = typename std::conditional<sizeof(T) == 1, uint8_t,
+	typename std::conditional<sizeof(T) == 2, uint16_t,
+	typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type;
+
+/** @brief SIMD instruction sets dispatched to, the value is the register width in bytes */
+enum class Simd : size_t
+{
+	SSE2 = 16,
+	AVX2 = 32,
+	AVX512 = 64,
+};
+
+/** @brief widest Simd the running cpu supports */
+inline Simd simdDetect(){
+#if GM_SIMD_DISPATCH
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+		&& __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl"))
+		return Simd::AVX512;
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return Simd::AVX2;
+	return Simd::SSE2;
+#else
+	return REG_SZ >= 64 ? Simd::AVX512 : REG_SZ >= 32 ? Simd::AVX2 : Simd::SSE2;
+#endif
+}
+
+/**
+ * @brief Simd the dispatched kernels use, detected once	\n
+ * $GM_SIMD (sse2, avx2 or avx512) can lower it, for testing or to avoid
+ * AVX-512 frequency drops, it is never raised above what the cpu supports
+ */
+inline Simd simd(){
+	static const Simd s = []{
+		Simd cpu = simdDetect();
+		const char* env = std::getenv("GM_SIMD");
+		if(!env)
+			return cpu;
+		Simd want = cpu;
+		if(!strcmp(env, "sse2")) want = Simd::SSE2;
+		else if(!strcmp(env, "avx2")) want = Simd::AVX2;
+		else if(!strcmp(env, "avx512")) want = Simd::AVX512;
+		return want < cpu ? want : cpu;
+	}();
+	return s;
+}
+
+/** @brief register width in bytes of the dispatched kernels */
+inline size_t simdBytes(){ return (size_t)simd(); }
+
+/** @brief Returns the argument matching simd(), usually kernel wrappers */
+template<class T>
+T simdPick(T sse2, T avx2, T avx512){
+	switch(simd()){
+		case Simd::AVX512: return avx512;
+		case Simd::AVX2: return avx2;
+		default: return sse2;
+	}
+}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <algorithm>
+
+namespace gm
+{
+
+/**
+ * Growth policies of gm::vector, its second template parameter	\n
+ * A policy has
+ * `static size_t next(size_t capacity, size_t needed, size_t elemSize)`,
+ * the new capacity (>= needed) when capacity is exceeded, and
+ * `static void onRealloc(size_t size, size_t capacity, size_t elemSize, bool remapped)`,
+ * called after every reallocation.
+ * ```cpp
+	gm::vector<int> a; // Grow1_5x
+	gm::vector<int, gm::Grow2x> b;
+	gm::vector<char, gm::GrowChunked<(64<<20)>> c; // +64 MiB steps once past 64 MiB
+	gm::vector<int, gm::GrowCounted<gm::Grow1_5x>> d;
+	gm::GrowCounted<gm::Grow1_5x>::stats().reallocations;
+ * ```
+ */
+
+/** @brief capacity*Num/Den, grows by at least one elem */
+template<size_t Num, size_t Den>
+struct GrowGeometric
+{
+	static_assert(Num > Den, "GrowGeometric: factor must be > 1");
+
+	static size_t next(size_t capacity, size_t needed, size_t){
+		size_t c = capacity/Den*Num + capacity%Den*Num/Den;
+		return std::max(std::max(c, capacity + 1), needed);
+	}
+	static void onRealloc(size_t, size_t, size_t, bool){}
+};
+
+/** @brief 1.5x, wastes at most a third of the capacity,
+ * and freed blocks can add up to the next request */
+using Grow1_5x = GrowGeometric<3, 2>;
+
+/** @brief 2x, fewer reallocations, wastes up to half the capacity */
+using Grow2x = GrowGeometric<2, 1>;
+
+/** @brief Base, rounded up so the buffer ends on a Page bytes boundary,
+ * the rest of the last page would be allocated anyway */
+template<class Base = Grow1_5x, size_t Page = 4096>
+struct GrowPageRounded
+{
+	static size_t next(size_t capacity, size_t needed, size_t elemSize){
+		size_t c = Base::next(capacity, needed, elemSize);
+		size_t bytes = (c*elemSize + Page-1)/Page*Page;
+		return bytes/elemSize;
+	}
+	static void onRealloc(size_t size, size_t capacity, size_t elemSize, bool remapped){
+		Base::onRealloc(size, capacity, elemSize, remapped);
+	}
+};
+
+/** @brief Base until the buffer has ChunkBytes, then ChunkBytes more each time,
+ * caps the slack of huge vectors (mapped buffers grow without copy, see al_remap) */
+template<size_t ChunkBytes, class Base = Grow1_5x>
+struct GrowChunked
+{
+	static size_t next(size_t capacity, size_t needed, size_t elemSize){
+		if(capacity*elemSize < ChunkBytes)
+			return Base::next(capacity, needed, elemSize);
+		size_t chunk = std::max<size_t>(ChunkBytes/elemSize, 1);
+		return std::max(capacity + chunk, needed);
+	}
+	static void onRealloc(size_t size, size_t capacity, size_t elemSize, bool remapped){
+		Base::onRealloc(size, capacity, elemSize, remapped);
+	}
+};
+
+/** @brief counters of GrowCounted */
+struct GrowthStats
+{
+	std::atomic<size_t> reallocations{0};
+	std::atomic<size_t> remaps{0}; //!< reallocations done by mremap, without copy
+	std::atomic<size_t> bytesCopied{0};
+	std::atomic<size_t> peakSlack{0}; //!< max unused bytes right after a reallocation
+
+	void reset(){
+		reallocations = 0;
+		remaps = 0;
+		bytesCopied = 0;
+		peakSlack = 0;
+	}
+};
+
+/** @brief Base, counting the reallocations of every vector using it in stats() */
+template<class Base = Grow1_5x>
+struct GrowCounted
+{
+	static GrowthStats& stats(){
+		static GrowthStats s;
+		return s;
+	}
+
+	static size_t next(size_t capacity, size_t needed, size_t elemSize){
+		return Base::next(capacity, needed, elemSize);
+	}
+	static void onRealloc(size_t size, size_t capacity, size_t elemSize, bool remapped){
+		GrowthStats& s = stats();
+		s.reallocations.fetch_add(1, std::memory_order_relaxed);
+		if(remapped)
+			s.remaps.fetch_add(1, std::memory_order_relaxed);
+		else
+			s.bytesCopied.fetch_add(size*elemSize, std::memory_order_relaxed);
+		size_t slack = capacity > size ? (capacity - size)*elemSize : 0;
+		size_t peak = s.peakSlack.load(std::memory_order_relaxed);
+		while(slack > peak && !s.peakSlack.compare_exchange_weak(peak, slack,
+			std::memory_order_relaxed))
+			;
+		Base::onRealloc(size, capacity, elemSize, remapped);
+	}
+};
+
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cmath>
+#include <utility>
+
 #include "varray.hpp"
 
 namespace gm
@@ -46,14 +49,14 @@ protected:
 
 public:
 	/** @brief n of elems in a vec */
-	size_t vecN() { return varr.vecN(); }
+	size_t vecN() const { return varr.vecN(); }
 	/** @brief Sets size to n elems (if existed: frees old varray pointer) */
 	void alloc(size_t size){
 		mSize = size;
 		mSizeVec = mSize/vecN();
-		mSizeMem = calcPadSize(mSize);
+		mSizeMem = calcPadSize<Elem>(mSize);
 		mSizeVecMem = mSizeMem/vecN();
-		mEndVec = Lower_Multiple(mSize, vecN());
+		mEndVec = lowerMultiple(mSize, vecN());
 		mPad = mSizeMem - mSize;
 		memAlloc(mSizeMem);
 	}
@@ -69,6 +72,10 @@ public:
 
 	/** @brief n of elems in a row/column */
 	size_t size() const { return mSize; }
+	/** @brief n of rows, size() */
+	size_t rows() const { return mSize; }
+	/** @brief n of columns, size() */
+	size_t cols() const { return mSize; }
 
 	/** @brief n of elems in a row/column in memory */
 	size_t sizeMem() const { return mSizeMem; }
@@ -90,6 +97,11 @@ public:
 	 * @return index */
 	size_t remInd(size_t index) const { return index*vecN(); }
 
+	/** @brief varray of the elems, sizeMem()*sizeMem() with the padding */
+	varray<Elem>& mem(){ return varr; }
+	/** @copydoc mem() */
+	const varray<Elem>& mem() const { return varr; }
+
 	/** @brief size of the padding in the matrix */
 	size_t pad(){ return mPad; }
 
@@ -100,12 +112,12 @@ public:
 	}
 
 	/** @brief returns vec<elem> at position */
-	vec<Elem>& atv(size_t i, size_t j) {
-		return varr.atv(indVecMem(i,j));
+	Vec<Elem>& atv(size_t i, size_t j) {
+		return varr.atV(indVecMem(i,j));
 	}
 	/** @copydoc atv(size_t,size_t) */
-	const vec<Elem>& atv(size_t i, size_t j) const {
-		return varr.atv(indVecMem(i,j));
+	const Vec<Elem>& atv(size_t i, size_t j) const {
+		return varr.atV(indVecMem(i,j));
 	}
 
 	/** @brief returns element memory index at position */
@@ -142,12 +154,12 @@ public:
 	}
 
 	/** @copydoc Matrix::atv(size_t, size_t) */
-	vec<Elem>& atv(size_t i, size_t j) {
-		return varr.atv(indVecMem(i,j));
+	Vec<Elem>& atv(size_t i, size_t j) {
+		return varr.atV(indVecMem(i,j));
 	}
 	/** @copydoc Matrix::atv(size_t, size_t) */
-	const vec<Elem>& atv(size_t i, size_t j) const {
-		return varr.atv(indVecMem(i,j));
+	const Vec<Elem>& atv(size_t i, size_t j) const {
+		return varr.atV(indVecMem(i,j));
 	}
 
 	/** @copydoc Matrix::indMem(size_t, size_t) const */
@@ -170,7 +182,16 @@ void swap_rows(Mat& M, size_t row0, size_t row1){
 	if(row0 == row1)
 		return;
 	for(size_t j = 0; j < M.size(); j++){
-		swap(M.at(row0, j), M.at(row1, j));
+		std::swap(M.at(row0, j), M.at(row1, j));
+	}
+}
+/** @brief swaps two rows of a row major Matrix a Vec at a time, padding included */
+template<class Elem>
+void swap_rows(Matrix<Elem>& M, size_t row0, size_t row1){
+	if(row0 == row1)
+		return;
+	for(size_t j = 0; j < M.sizeVecMem(); j++){
+		std::swap(M.atv(row0, j), M.atv(row1, j));
 	}
 }
 /**
@@ -212,9 +233,9 @@ template<class Mat>
 void print(Mat& M){
 	for(size_t i = 0; i < M.size(); i++){
 		for(size_t j = 0; j < M.size(); j++){
-			cout << M.at(i, j) <<" ";
+			std::cout << M.at(i, j) <<" ";
 		}
-		cout << endl;
+		std::cout << std::endl;
 	}
 }
 /** @brief sets I to identity */
@@ -247,7 +268,7 @@ void randomMatrix(Mat& M){
  */
 template<class Mat>
 void printm(Mat& M){
-	cout<<  M.size() <<"\n";
+	std::cout<<  M.size() <<"\n";
 	print(M);
 }
 
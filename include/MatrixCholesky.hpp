@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include "Matrix.hpp"
+#include "MatrixMultiply.hpp"
+#include "MatrixTriangular.hpp"
+#include "Reduce.hpp"
+#include "ThreadPool.hpp"
+
+/** @brief columns of a panel of cholesky_factor(), the depth of its GEMM updates */
+#define CHOL_NB (192)
+/** @brief columns of a panel solved by row updates at a time, the rest by GEMM */
+#define CHOL_SW (32)
+
+namespace gm
+{
+
+namespace detail
+{
+
+/**
+ * @brief Diagonal block [s, e) of a strip of L, left-looking	\n
+ * Every elem is a dot product of two rows over [s, j),
+ * the columns before s already subtracted.
+ * @return false if a pivot is not > 0
+ */
+template<class Elem>
+bool cholDiag(Matrix<Elem>& A, size_t s, size_t e){
+	for(size_t i = s; i < e; ++i){
+		Elem* ri = elemPtr(A, i, s);
+		for(size_t j = 0; j <= i - s; ++j){
+			const Elem* rj = elemPtr(A, s + j, s);
+			Elem v = ri[j] - dot(ri, rj, j);
+			if(s + j < i)
+				ri[j] = v/rj[j];
+			else if(v > Elem(0))
+				ri[j] = std::sqrt(v);
+			else
+				return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Columns [s, e) of L on the rows [i0, i1) below the diagonal block	\n
+ * The rows of an elem depend on each other, the rows don't: the tile is
+ * transposed into buf ((e-s)*(i1-i0) elems) so a column of L is
+ * an axpy per column before it over all the rows of the tile.
+ */
+template<class Elem>
+void cholStripRows(Matrix<Elem>& A, size_t s, size_t e, size_t i0, size_t i1, Elem* buf){
+	const size_t w = e - s;
+	const size_t m = i1 - i0;
+	for(size_t i = 0; i < m; ++i){
+		const Elem* ri = elemPtr(A, i0 + i, s);
+		for(size_t j = 0; j < w; ++j)
+			buf[j*m + i] = ri[j];
+	}
+	for(size_t j = 0; j < w; ++j){
+		Elem* cj = buf + j*m;
+		const Elem* lj = elemPtr(A, s + j, s);
+		for(size_t p = 0; p < j; ++p)
+			axpy(-lj[p], buf + p*m, cj, m);
+		Elem inv = Elem(1)/lj[j];
+		for(size_t i = 0; i < m; ++i)
+			cj[i] *= inv;
+	}
+	for(size_t i = 0; i < m; ++i){
+		Elem* ri = elemPtr(A, i0 + i, s);
+		for(size_t j = 0; j < w; ++j)
+			ri[j] = buf[j*m + i];
+	}
+}
+
+/** @brief fn(i0, i1, w) on the tiles of th rows of [r0, n), the last first, w the task */
+template<class Fn>
+void cholRowTiles(size_t r0, size_t n, size_t th, size_t nThreads, ThreadPool& pool, const Fn& fn){
+	size_t tiles = (n - r0 + th - 1)/th;
+	std::atomic<size_t> next(0);
+	pool.run(std::min(nThreads, tiles), [&](size_t w){
+		for(size_t t = next++; t < tiles; t = next++){
+			size_t i0 = r0 + (tiles - 1 - t)*th;
+			fn(i0, std::min(i0 + th, n), w);
+		}
+	});
+}
+
+/**
+ * @brief b = A^-1 b with the Cholesky factor in the memory of M:
+ * L row major, or L^T if upper (a MatrixColMajor)	\n
+ * Each triangle is walked along the rows in memory: dot products
+ * when they are the rows of the triangle, axpys when they are its columns.
+ */
+template<class Elem>
+void cholSolve(const Matrix<Elem>& M, varray<Elem>& b, bool upper){
+	const size_t n = M.size();
+	assert(b.size() == n && "cholesky_solve: sizes differ");
+	Elem* x = b.begin();
+	// L y = b
+	for(size_t i = 0; i < n; ++i){
+		if(upper){
+			x[i] /= M.at(i, i);
+			axpy(-x[i], elemPtr(M, i, i + 1), x + i + 1, n - i - 1);
+		} else
+			x[i] = (x[i] - dot(elemPtr(M, i, 0), x, i)) / M.at(i, i);
+	}
+	// L^T x = y
+	for(size_t i = n; i-- > 0; ){
+		if(upper)
+			x[i] = (x[i] - dot(elemPtr(M, i, i + 1), x + i + 1, n - i - 1)) / M.at(i, i);
+		else {
+			x[i] /= M.at(i, i);
+			axpy(-x[i], elemPtr(M, i, 0), x, i);
+		}
+	}
+}
+
+}
+
+/**
+ * @brief Cholesky factorization A = L*L^T of a symmetric positive definite A,
+ * in place: A is overwritten by L, its strict upper triangle set to 0	\n
+ * Right-looking and blocked: each panel of CHOL_NB columns is factored
+ * left-looking in strips of CHOL_SW columns (the columns before the strip
+ * subtracted with one GEMM, the strip by row updates), then
+ * A22 -= L21 * L21^T on its lower triangle only, a GEMM of depth CHOL_NB
+ * on the multiply() kernels. Row tiles are spread over the pool.
+ * Only the lower triangle of A is read, about half the flops of
+ * lu_factor() and no pivoting.
+ * ```cpp
+	if(!gm::cholesky_factor(C))
+		throw std::runtime_error("not positive definite");
+	gm::cholesky_solve(C, b);
+ * ```
+ * @param nThreads max n of threads used, 0 means every thread of the pool
+ * @param nb panel width, 0 means CHOL_NB
+ * @return false if A is not positive definite, A is then partly overwritten
+ */
+template<class Elem>
+bool cholesky_factor(Matrix<Elem>& A, size_t nThreads = 0, size_t nb = 0,
+	ThreadPool& pool = threadPool())
+{
+	const size_t n = A.size();
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+
+	size_t nr = gemmKernel<Elem>().nr;
+	GemmBlocking bl;
+	bl.fill<Elem>().normalize(nr);
+	// GEMM updates on whole micro-kernel tiles, see gemm_update()
+	nb = upperMultiple(nb ? nb : CHOL_NB, nr);
+	const size_t sw = upperMultiple(CHOL_SW, nr);
+	const size_t th = upperMultiple(CHOL_NB, GEMM_MR);
+	size_t kcMax = std::min(bl.kc, nb);
+	std::vector<varray<Elem>> Ap(nThreads), Bp(nThreads), Sp(nThreads);
+	for(size_t w = 0; w < nThreads; ++w){
+		Ap[w].alloc(bl.mc*kcMax);
+		Bp[w].alloc(bl.nc*kcMax);
+		Sp[w].alloc(th*sw);
+	}
+
+	for(size_t k = 0; k < n; k += nb){
+		size_t kb = std::min(k + nb, n);
+		for(size_t s = k; s < kb; s += sw){
+			size_t e = std::min(s + sw, kb);
+			if(s > k)
+				detail::cholRowTiles(s, n, th, nThreads, pool, [&](size_t i0, size_t i1, size_t w){
+					gemm_update(view(A), A, transposed(A), i0, i1, s, e, k, s - k, Elem(-1), bl,
+						Ap[w].begin(), Bp[w].begin());
+				});
+			if(!detail::cholDiag(A, s, e))
+				return false;
+			if(e < n)
+				detail::cholRowTiles(e, n, th, nThreads, pool, [&](size_t i0, size_t i1, size_t w){
+					detail::cholStripRows(A, s, e, i0, i1, Sp[w].begin());
+				});
+		}
+		if(kb == n)
+			break;
+		// A22 -= L21 L21^T, row tiles up to their diagonal
+		detail::cholRowTiles(kb, n, th, nThreads, pool, [&](size_t i0, size_t i1, size_t w){
+			size_t j1 = std::min(kb + upperMultiple(i1 - kb, nr), n);
+			gemm_update(view(A), A, transposed(A), i0, i1, kb, j1, k, kb - k, Elem(-1), bl,
+				Ap[w].begin(), Bp[w].begin());
+		});
+	}
+	for(size_t i = 0; i < n; ++i){
+		Elem* ri = detail::elemPtr(A, i, 0);
+		std::fill(ri + i + 1, ri + n, Elem(0));
+	}
+	return true;
+}
+
+/**
+ * @brief Cholesky factorization of a column major A, see cholesky_factor(Matrix&)	\n
+ * The memory of a symmetric A holds A either way, it is factored as
+ * row major, then L is mirrored to where at() of MatrixColMajor reads it.
+ * Only the upper triangle of A is read.
+ */
+template<class Elem>
+bool cholesky_factor(MatrixColMajor<Elem>& A, size_t nThreads = 0, size_t nb = 0,
+	ThreadPool& pool = threadPool())
+{
+	Matrix<Elem>& M = A;
+	if(!cholesky_factor(M, nThreads, nb, pool))
+		return false;
+	for(size_t i = 0; i < M.size(); ++i)
+		for(size_t j = 0; j < i; ++j){
+			M.at(j, i) = M.at(i, j);
+			M.at(i, j) = Elem(0);
+		}
+	return true;
+}
+
+/**
+ * @brief Solves A x = b with the factor L of cholesky_factor(), b is overwritten by x	\n
+ * Forward substitution with L then backward with L^T
+ */
+template<class Elem>
+void cholesky_solve(const Matrix<Elem>& L, varray<Elem>& b){
+	detail::cholSolve(L, b, false);
+}
+
+/** @copydoc cholesky_solve(const Matrix<Elem>&, varray<Elem>&) */
+template<class Elem>
+void cholesky_solve(const MatrixColMajor<Elem>& L, varray<Elem>& b){
+	detail::cholSolve(L, b, true);
+}
+
+/**
+ * @brief Solves A X = B for the n columns of B with the factor L of
+ * cholesky_factor(), B is overwritten by X	\n
+ * trsm_lower() with L then trsm_upper() with its transposed() view
+ */
+template<class Elem, class MatL>
+void cholesky_solve(const MatL& L, Matrix<Elem>& B,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	trsm_lower(L, B, false, nThreads, pool);
+	trsm_upper(transposed(L), B, false, nThreads, pool);
+}
+
+template<class Elem, class MatL>
+void cholesky_solve(const MatL& L, MatrixColMajor<Elem>& B,
+	size_t nThreads = 0, ThreadPool& pool = threadPool()) = delete;
+
+}
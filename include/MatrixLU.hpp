@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include "Matrix.hpp"
+#include "MatrixMultiply.hpp"
+#include "MatrixTriangular.hpp"
+#include "Reduce.hpp"
+#include "ThreadPool.hpp"
+
+/** @brief columns of a panel of lu_factor(), the depth of its GEMM updates */
+#define LU_NB (192)
+/** @brief columns of a panel factored at a time, the strip of U rows they
+ * update the rest of the panel with stays in L1 */
+#define LU_IB (16)
+
+namespace gm
+{
+
+namespace detail
+{
+
+/**
+ * @brief LU with partial pivoting of the panel A[k:n, k:k+b]	\n
+ * Factors LU_IB columns at a time elem by elem, then updates the rest of
+ * the panel with their rows. Pivot rows are swapped whole, so the L
+ * on the left and the trailing matrix on the right follow.
+ * @param piv piv[j] is set to the row swapped with row j
+ * @return false if a column had no non 0 pivot, it is left as is
+ */
+template<class Elem>
+bool luPanel(Matrix<Elem>& A, size_t k, size_t b, size_t* piv){
+	const size_t n = A.size();
+	const size_t kb = k + b;
+	bool ok = true;
+	for(size_t s = k; s < kb; s += LU_IB){
+		size_t e = std::min(s + LU_IB, kb);
+		for(size_t j = s; j < e; ++j){
+			size_t p = j;
+			Elem maxv = std::abs(A.at(j, j));
+			for(size_t i = j + 1; i < n; ++i){
+				Elem v = std::abs(A.at(i, j));
+				if(v > maxv){
+					maxv = v;
+					p = i;
+				}
+			}
+			piv[j] = p;
+			swap_rows(A, j, p);
+			if(maxv == Elem(0)){
+				ok = false;
+				continue;
+			}
+			const Elem* rj = elemPtr(A, j, 0);
+			Elem r = Elem(1)/rj[j];
+			for(size_t i = j + 1; i < n; ++i){
+				Elem* ri = elemPtr(A, i, 0);
+				Elem l = ri[j] *= r;
+				for(size_t c = j + 1; c < e; ++c)
+					ri[c] -= l*rj[c];
+			}
+		}
+		if(e == kb)
+			continue;
+		// U rows of the strip, then the rank LU_IB update of the panel below
+		for(size_t i = s + 1; i < e; ++i)
+			for(size_t j = s; j < i; ++j)
+				axpy(-A.at(i, j), elemPtr(A, j, e), elemPtr(A, i, e), kb - e);
+		for(size_t i = e; i < n; ++i)
+			for(size_t j = s; j < e; ++j)
+				axpy(-A.at(i, j), elemPtr(A, j, e), elemPtr(A, i, e), kb - e);
+	}
+	return ok;
+}
+
+}
+
+/**
+ * @brief LU factorization with partial pivoting, in place: P*A = L*U	\n
+ * Right-looking and blocked (getrf-like): each panel of LU_NB columns is
+ * factored by luPanel(), then on column tiles spread over the pool
+ * U12 = L11^-1 * A12 and the trailing A22 -= L21 * U12, a GEMM of
+ * depth LU_NB on the multiply() kernels. L is unit lower, below the
+ * diagonal, U upper, from the diagonal.
+ * ```cpp
+	std::vector<size_t> piv;
+	gm::lu_factor(A, piv);
+	gm::lu_solve(A, piv, b); // b = A^-1 b, as many times as needed
+ * ```
+ * @param piv set to the n row swaps, row i was swapped with piv[i] at step i
+ * @param nThreads max n of threads used, 0 means every thread of the pool
+ * @param nb panel width, 0 means LU_NB
+ * @return false if A is singular, the factors are complete but U has a 0
+ * on the diagonal
+ */
+template<class Elem>
+bool lu_factor(Matrix<Elem>& A, std::vector<size_t>& piv, size_t nThreads = 0,
+	size_t nb = 0, ThreadPool& pool = threadPool())
+{
+	const size_t n = A.size();
+	piv.resize(n);
+	if(n == 0)
+		return true;
+	if(nb == 0)
+		nb = LU_NB;
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+
+	size_t nr = gemmKernel<Elem>().nr;
+	GemmBlocking bl;
+	bl.fill<Elem>().normalize(nr);
+	size_t kcMax = std::min(bl.kc, nb);
+	std::vector<varray<Elem>> Ap(nThreads), Bp(nThreads);
+
+	bool ok = true;
+	for(size_t k = 0; k < n; k += nb){
+		size_t b = std::min(nb, n - k);
+		size_t kb = k + b;
+		ok &= detail::luPanel(A, k, b, piv.data());
+		if(kb == n)
+			break;
+
+		size_t cols = n - kb;
+		size_t tile = detail::tileCols(cols, nThreads, nr, bl.nc);
+		size_t tiles = (cols + tile - 1)/tile;
+		std::atomic<size_t> next(0);
+		pool.run(std::min(nThreads, tiles), [&](size_t w){
+			if(Ap[w].size() == 0){
+				Ap[w].alloc(bl.mc*kcMax);
+				Bp[w].alloc(bl.nc*kcMax);
+			}
+			for(size_t t = next++; t < tiles; t = next++){
+				size_t j0 = kb + t*tile;
+				size_t j1 = std::min(j0 + tile, n);
+				for(size_t i = k + 1; i < kb; ++i)
+					for(size_t j = k; j < i; ++j)
+						axpy(-A.at(i, j), detail::elemPtr(A, j, j0), detail::elemPtr(A, i, j0), j1 - j0);
+				gemm_update(view(A), A, A, kb, n, j0, j1, k, b, Elem(-1), bl,
+					Ap[w].begin(), Bp[w].begin());
+			}
+		});
+	}
+	return ok;
+}
+
+/**
+ * @brief Solves A x = b with the factors of lu_factor(), b is overwritten by x	\n
+ * Forward and back substitution, a vectorized dot product per row
+ */
+template<class Elem>
+void lu_solve(const Matrix<Elem>& LU, const std::vector<size_t>& piv, varray<Elem>& b){
+	const size_t n = LU.size();
+	assert(b.size() == n && piv.size() == n && "lu_solve: sizes differ");
+	Elem* x = b.begin();
+	for(size_t i = 0; i < n; ++i)
+		std::swap(x[i], x[piv[i]]);
+	for(size_t i = 1; i < n; ++i)
+		x[i] -= dot(detail::elemPtr(LU, i, 0), x, i);
+	for(size_t i = n; i-- > 0; )
+		x[i] = (x[i] - dot(detail::elemPtr(LU, i, i + 1), x + i + 1, n - i - 1)) / LU.at(i, i);
+}
+
+/**
+ * @brief Solves A X = B for the n columns of B with the factors of lu_factor(),
+ * B is overwritten by X	\n
+ * The rows of B are permuted, then trsm_lower() with the unit L
+ * and trsm_upper() with U, blocked on the GEMM kernels.
+ */
+template<class Elem>
+void lu_solve(const Matrix<Elem>& LU, const std::vector<size_t>& piv, Matrix<Elem>& B,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	const size_t n = LU.size();
+	assert(B.size() == n && piv.size() == n && "lu_solve: sizes differ");
+	for(size_t i = 0; i < n; ++i)
+		swap_rows(B, i, piv[i]);
+	trsm_lower(LU, B, true, nThreads, pool);
+	trsm_upper(LU, B, false, nThreads, pool);
+}
+
+}
@@ -0,0 +1,518 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "Matrix.hpp"
+#include "MatrixView.hpp"
+#include "ThreadPool.hpp"
+#include "Dispatch.hpp"
+
+namespace gm
+{
+
+/** @brief rows of C computed by one micro-kernel call */
+#define GEMM_MR (6)
+/** @brief registers per row of C computed by one micro-kernel call */
+#define GEMM_NRV (2)
+
+namespace detail
+{
+/** @brief loads the default tuning profile once, at the first GemmBlocking::tuned() */
+inline void tuningAtFirstUse();
+}
+
+/**
+ * @brief Block sizes used by multiply(), in elems	\n
+ * nc: columns of the B panel kept in L3	\n
+ * kc: depth of the A block and B panel, the A block (mc x kc) is kept in L2	\n
+ * mc: rows of the A block	\n
+ * l1: columns of the B panel swept against the whole A block while in L1	\n
+ * 0 means the default: the tuned() sizes if a profile was loaded,
+ * else the B3L3, B3L2 and B3L1 blocks for the probed cacheInfo()
+ */
+struct GemmBlocking
+{
+	size_t nc = 0;
+	size_t kc = 0;
+	size_t mc = 0;
+	size_t l1 = 0;
+
+	/** @brief Block sizes used for the fields left as 0, 0 again means
+	 * blocks from the cache sizes, set by tune() (Tune.hpp) / loadTuning().
+	 * The first call loads the default profile, see loadTuning() */
+	template<class Elem>
+	static GemmBlocking& tuned(){
+		detail::tuningAtFirstUse();
+		return tunedStore<Elem>();
+	}
+
+	/** @brief storage of tuned(), read and written without loading the profile */
+	template<class Elem>
+	static GemmBlocking& tunedStore(){
+		static GemmBlocking bl;
+		return bl;
+	}
+
+	/** @brief sets the sizes left as 0 to the tuned() ones,
+	 * or else blocks that fit 3 matrices per cache level */
+	template<class Elem>
+	GemmBlocking& fill(const CacheInfo& ci = cacheInfo()){
+		const GemmBlocking& t = tuned<Elem>();
+		if(!nc) nc = t.nc ? t.nc : ci.block<Elem>(3, 3);
+		if(!kc) kc = t.kc ? t.kc : ci.block<Elem>(2, 3);
+		if(!mc) mc = t.mc ? t.mc : ci.block<Elem>(2, 3);
+		if(!l1) l1 = t.l1 ? t.l1 : ci.block<Elem>(1, 3);
+		return *this;
+	}
+
+	/** @brief rounds the block sizes to multiples of the micro-kernel tile
+	 * @param nr columns of the micro-kernel tile */
+	GemmBlocking& normalize(size_t nr){
+		kc = std::max<size_t>(kc, 1);
+		mc = upperMultiple(std::max<size_t>(mc, GEMM_MR), GEMM_MR);
+		l1 = upperMultiple(std::max<size_t>(l1, nr), nr);
+		nc = upperMultiple(std::max<size_t>(nc, l1), l1);
+		return *this;
+	}
+};
+
+/** @brief name of the elem type in the tuning profile */
+template<class Elem> const char* tuneTypeName();
+template<> inline const char* tuneTypeName<float>() { return "float"; }
+template<> inline const char* tuneTypeName<double>() { return "double"; }
+
+/**
+ * @brief Where the tuning profile is kept:
+ * $GM_TUNE_PROFILE, else $HOME/.grimoire_tune, else ./.grimoire_tune
+ */
+inline std::string tuneProfilePath(){
+	if(const char* path = std::getenv("GM_TUNE_PROFILE"))
+		return path;
+	if(const char* home = std::getenv("HOME"))
+		return std::string(home) + "/.grimoire_tune";
+	return ".grimoire_tune";
+}
+
+namespace detail
+{
+
+/** @brief once flag of the default profile and whether it was loaded */
+struct TuningState
+{
+	std::once_flag once;
+	bool loaded = false;
+};
+inline TuningState& tuningState(){
+	static TuningState state;
+	return state;
+}
+
+/** @brief reads the profile at path into GemmBlocking::tunedStore(), see loadTuning() */
+inline bool loadTuningFile(const std::string& path){
+	std::ifstream in(path);
+	if(!in)
+		return false;
+	const CacheInfo& ci = cacheInfo();
+	bool sameCache = false;
+	std::string line;
+	while(std::getline(in, line)){
+		std::istringstream ss(line);
+		std::string key, type;
+		if(!(ss >> key) || key[0] == '#')
+			continue;
+		if(key == "cache"){
+			CacheInfo file;
+			ss >> file.lineSize >> file.l1 >> file.l2 >> file.l3;
+			sameCache = ss && file.lineSize == ci.lineSize && file.l1 == ci.l1
+				&& file.l2 == ci.l2 && file.l3 == ci.l3;
+			if(!sameCache)
+				return false;
+		}else if(key == "gemm" && sameCache){
+			GemmBlocking bl;
+			if(!(ss >> type >> bl.nc >> bl.kc >> bl.mc >> bl.l1))
+				continue;
+			if(type == tuneTypeName<float>())
+				GemmBlocking::tunedStore<float>() = bl;
+			else if(type == tuneTypeName<double>())
+				GemmBlocking::tunedStore<double>() = bl;
+		}
+	}
+	return sameCache;
+}
+
+inline void tuningAtFirstUse(){
+	TuningState& state = tuningState();
+	std::call_once(state.once, [&]{
+		state.loaded = loadTuningFile(tuneProfilePath());
+	});
+}
+
+}
+
+/**
+ * @brief Loads the profile written by tune() into GemmBlocking::tuned()	\n
+ * The default profile is loaded by the first GemmBlocking::tuned(), so
+ * every multiply() gets it without calling this. A profile measured on
+ * other caches than cacheInfo() is ignored, so a profile copied to
+ * different hardware doesn't hurt
+ * @return false if there is no profile or it is for other hardware
+ */
+inline bool loadTuning(const std::string& path = tuneProfilePath()){
+	// the default profile can't be loaded over this one later
+	detail::tuningAtFirstUse();
+	return detail::loadTuningFile(path);
+}
+
+/** @brief whether the default profile was found and loaded at the first GemmBlocking::tuned() */
+inline bool tuningAtStartup(){
+	detail::tuningAtFirstUse();
+	return detail::tuningState().loaded;
+}
+
+/**
+ * @brief Copies alpha*A[i0:i0+mc, k0:k0+kc] into Ap as GEMM_MR tall row panels,
+ * each stored column by column (kc*GEMM_MR elems), rows past A.rows() are 0
+ */
+template<class Elem, class Mat>
+void gemm_packA(Elem* Ap, const Mat& A, size_t i0, size_t mc, size_t k0, size_t kc,
+	Elem alpha = Elem(1))
+{
+	size_t iEnd = std::min(i0 + mc, A.rows());
+	for(size_t ir = 0; ir < mc; ir += GEMM_MR){
+		Elem* panel = Ap + ir*kc;
+		for(size_t p = 0; p < kc; ++p){
+			unroll(r, GEMM_MR){
+				size_t i = i0 + ir + r;
+				panel[p*GEMM_MR + r] = i < iEnd ? alpha*A.at(i, k0 + p) : Elem(0);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Copies B[k0:k0+kc, j0:j0+nc] into Bp as nr wide column panels,
+ * each stored row by row (kc*nr elems), columns past B.cols() are 0
+ */
+template<class Elem, class Mat>
+void gemm_packB(Elem* Bp, const Mat& B, size_t k0, size_t kc, size_t j0, size_t nc, size_t nr){
+	size_t jEnd = std::min(j0 + nc, B.cols());
+	for(size_t jr = 0; jr < nc; jr += nr){
+		Elem* panel = Bp + jr*kc;
+		for(size_t p = 0; p < kc; ++p){
+			for(size_t c = 0; c < nr; ++c){
+				size_t j = j0 + jr + c;
+				panel[p*nr + c] = j < jEnd ? B.at(k0 + p, j) : Elem(0);
+			}
+		}
+	}
+}
+
+/** @brief columns of C computed by one micro-kernel call with W byte registers */
+template<class Elem, size_t W>
+constexpr size_t gemm_nr(){ return GEMM_NRV*(W/sizeof(Elem)); }
+
+/**
+ * @brief Register tiled micro-kernel, computes the GEMM_MR x gemm_nr() tile
+ * Ap * Bp and writes it into C at (i0, j0), full tiles with W byte stores,
+ * edge tiles elem by elem
+ * @param Ap packed GEMM_MR tall row panel of A
+ * @param Bp packed gemm_nr() wide column panel of B, aligned to W
+ * @param accumulate if false C is overwritten, else added to
+ */
+template<class Elem, size_t W>
+GM_INLINE void gemm_kernel(size_t kc, const Elem* __restrict__ Ap, const Elem* __restrict__ Bp,
+	const MatrixView<Elem>& C, size_t i0, size_t j0, bool accumulate)
+{
+	using V = VecW<Elem, W>;
+	const size_t lanes = W/sizeof(Elem);
+	const V* Bv = (const V*)Bp;
+
+	V c[GEMM_MR][GEMM_NRV] = {};
+	for(size_t p = 0; p < kc; ++p){
+		V b[GEMM_NRV];
+		unroll(v, GEMM_NRV)
+			b[v] = Bv[p*GEMM_NRV + v];
+		unroll(r, GEMM_MR){
+			Elem a = Ap[p*GEMM_MR + r];
+			unroll(v, GEMM_NRV)
+				c[r][v] += a * b[v];
+		}
+	}
+
+	size_t mr = std::min<size_t>(GEMM_MR, C.rows() - i0);
+	size_t nr = std::min<size_t>(GEMM_NRV*lanes, C.cols() - j0);
+	if(mr == GEMM_MR && nr == GEMM_NRV*lanes){
+		unroll2D(r, GEMM_MR, v, GEMM_NRV){
+			VecWu<Elem, W>* dst = (VecWu<Elem, W>*)&C.at(i0 + r, j0 + v*lanes);
+			*dst = accumulate ? *dst + c[r][v] : c[r][v];
+		}
+		return;
+	}
+	for(size_t r = 0; r < mr; ++r){
+		for(size_t j = 0; j < nr; ++j){
+			Elem x = c[r][j/lanes][j%lanes];
+			if(accumulate)
+				C.at(i0 + r, j0 + j) += x;
+			else
+				C.at(i0 + r, j0 + j) = x;
+		}
+	}
+}
+
+/**
+ * @brief Multiplies the packed A block by the packed B panel into
+ * C[i0:i0+mc, j0:j0+nc], sweeping l1 wide slices of the B panel
+ * against every row panel of the A block so the slice stays in L1
+ */
+template<class Elem, size_t W>
+GM_INLINE void gemm_macroKernelW(const MatrixView<Elem>& C, const Elem* Ap, const Elem* Bp,
+	size_t i0, size_t mc, size_t j0, size_t nc, size_t kc,
+	const GemmBlocking& bl, bool accumulate)
+{
+	const size_t nr = gemm_nr<Elem, W>();
+	for(size_t jl = 0; jl < nc; jl += bl.l1){
+		size_t jlEnd = std::min(jl + bl.l1, nc);
+		for(size_t ir = 0; ir < mc; ir += GEMM_MR){
+			for(size_t jr = jl; jr < jlEnd; jr += nr)
+				gemm_kernel<Elem, W>(kc, Ap + ir*kc, Bp + jr*kc,
+					C, i0 + ir, j0 + jr, accumulate);
+		}
+	}
+}
+
+/** @copydoc gemm_macroKernelW */
+template<class Elem> GM_TARGET_SSE2
+void gemm_macroKernel_sse2(const MatrixView<Elem>& C, const Elem* Ap, const Elem* Bp,
+	size_t i0, size_t mc, size_t j0, size_t nc, size_t kc,
+	const GemmBlocking& bl, bool accumulate)
+{
+	gemm_macroKernelW<Elem, 16>(C, Ap, Bp, i0, mc, j0, nc, kc, bl, accumulate);
+}
+/** @copydoc gemm_macroKernelW */
+template<class Elem> GM_TARGET_AVX2
+void gemm_macroKernel_avx2(const MatrixView<Elem>& C, const Elem* Ap, const Elem* Bp,
+	size_t i0, size_t mc, size_t j0, size_t nc, size_t kc,
+	const GemmBlocking& bl, bool accumulate)
+{
+	gemm_macroKernelW<Elem, 32>(C, Ap, Bp, i0, mc, j0, nc, kc, bl, accumulate);
+}
+/** @copydoc gemm_macroKernelW */
+template<class Elem> GM_TARGET_AVX512
+void gemm_macroKernel_avx512(const MatrixView<Elem>& C, const Elem* Ap, const Elem* Bp,
+	size_t i0, size_t mc, size_t j0, size_t nc, size_t kc,
+	const GemmBlocking& bl, bool accumulate)
+{
+	gemm_macroKernelW<Elem, 64>(C, Ap, Bp, i0, mc, j0, nc, kc, bl, accumulate);
+}
+
+/** @brief macro-kernel for the simd() of the running cpu and its tile width */
+template<class Elem>
+struct GemmKernel
+{
+	using Fn = void(*)(const MatrixView<Elem>&, const Elem*, const Elem*,
+		size_t, size_t, size_t, size_t, size_t, const GemmBlocking&, bool);
+
+	Fn macroKernel;
+	size_t nr; //!< columns of the micro-kernel tile, packed B panels are this wide
+};
+
+/** @brief GemmKernel picked once by simd() */
+template<class Elem>
+const GemmKernel<Elem>& gemmKernel(){
+	static const GemmKernel<Elem> k = simdPick(
+		GemmKernel<Elem>{gemm_macroKernel_sse2<Elem>, gemm_nr<Elem, 16>()},
+		GemmKernel<Elem>{gemm_macroKernel_avx2<Elem>, gemm_nr<Elem, 32>()},
+		GemmKernel<Elem>{gemm_macroKernel_avx512<Elem>, gemm_nr<Elem, 64>()});
+	return k;
+}
+
+/**
+ * @brief C[i0:i1, j0:j0+nc] = A[i0:i1, :] * B[:, j0:j0+nc]	\n
+ * loops over the whole depth in kc steps, packing the B panel once per step
+ * and an A block per mc rows, Ap and Bp are the caller's scratch
+ * @param nc columns of the tile, a multiple of the micro-kernel width
+ */
+template<class Elem, class MatA, class MatB>
+void gemm_tile(const MatrixView<Elem>& C, const MatA& A, const MatB& B,
+	size_t i0, size_t i1, size_t j0, size_t nc,
+	const GemmBlocking& bl, Elem* Ap, Elem* Bp)
+{
+	size_t depth = A.cols();
+	const GemmKernel<Elem>& k = gemmKernel<Elem>();
+	for(size_t kk = 0; kk < depth; kk += bl.kc){
+		size_t kc = std::min(bl.kc, depth - kk);
+		gemm_packB(Bp, B, kk, kc, j0, nc, k.nr);
+		for(size_t ii = i0; ii < i1; ii += bl.mc){
+			size_t mc = std::min(upperMultiple(i1 - ii, GEMM_MR), bl.mc);
+			gemm_packA(Ap, A, ii, mc, kk, kc);
+			k.macroKernel(C, Ap, Bp, ii, mc, j0, nc, kc, bl, kk != 0);
+		}
+	}
+}
+
+/**
+ * @brief C[i0:i1, j0:j1] += alpha * A[i0:i1, k0:k0+kc] * B[k0:k0+kc, j0:j1]	\n
+ * The rank-kc update of the blocked factorizations, packed and computed
+ * like gemm_tile(). The micro-kernel works on whole tiles, so i1 - i0
+ * must be a multiple of GEMM_MR and j1 - j0 of gemmKernel().nr,
+ * unless i1 (j1) is C.rows() (C.cols()). C may be A or B if the blocks
+ * don't overlap.
+ * @param bl filled and normalized blocking, Ap and Bp scratch for its blocks
+ */
+template<class Elem, class MatA, class MatB>
+void gemm_update(MatrixView<Elem> C, const MatA& A, const MatB& B,
+	size_t i0, size_t i1, size_t j0, size_t j1, size_t k0, size_t kc, Elem alpha,
+	const GemmBlocking& bl, Elem* Ap, Elem* Bp)
+{
+	const GemmKernel<Elem>& k = gemmKernel<Elem>();
+	for(size_t jj = j0; jj < j1; jj += bl.nc){
+		size_t nc = std::min(upperMultiple(j1 - jj, k.nr), bl.nc);
+		for(size_t kk = k0; kk < k0 + kc; kk += bl.kc){
+			size_t kcc = std::min(bl.kc, k0 + kc - kk);
+			gemm_packB(Bp, B, kk, kcc, jj, nc, k.nr);
+			for(size_t ii = i0; ii < i1; ii += bl.mc){
+				size_t mc = std::min(upperMultiple(i1 - ii, GEMM_MR), bl.mc);
+				gemm_packA(Ap, A, ii, mc, kk, kcc, alpha);
+				k.macroKernel(C, Ap, Bp, ii, mc, jj, nc, kcc, bl, true);
+			}
+		}
+	}
+}
+
+/**
+ * @brief C = A * B	\n
+ * Cache blocked multiplication: B panels (kc x nc) are packed to fit L3,
+ * A blocks (mc x kc) to fit L2, and a register tiled micro-kernel
+ * computes GEMM_MR x GEMM_NRV registers of C at a time,
+ * with the register width of the running cpu (see Dispatch.hpp).	\n
+ * A and B can be any layout (accessed by at() while packing),
+ * C must be row major: a Matrix, a MatrixRC or a MatrixView of a block,
+ * C is m x n, A m x k and B k x n
+ * ```cpp
+	gm::Matrix<double> A(n), B(n), C(n);
+	gm::randomMatrix(A); gm::randomMatrix(B);
+	gm::multiply(C, A, B);
+ * ```
+ * @param bl block sizes, see GemmBlocking
+ */
+template<class Elem, class MatA, class MatB>
+void multiply(MatrixView<Elem> C, const MatA& A, const MatB& B, GemmBlocking bl = GemmBlocking())
+{
+	assert(A.rows() == C.rows() && B.cols() == C.cols() && A.cols() == B.rows() && "multiply: sizes differ");
+
+	size_t m = C.rows();
+	size_t n = C.cols();
+	if(A.cols() == 0){
+		for(size_t i = 0; i < m; ++i)
+			std::fill(C.row(i), C.row(i) + n, Elem(0));
+		return;
+	}
+	size_t nr = gemmKernel<Elem>().nr;
+	bl.fill<Elem>().normalize(nr);
+	size_t kcMax = std::min(bl.kc, A.cols());
+
+	varray<Elem> Ap(bl.mc*kcMax);
+	varray<Elem> Bp(bl.nc*kcMax);
+
+	for(size_t jj = 0; jj < n; jj += bl.nc){
+		size_t nc = std::min(upperMultiple(n - jj, nr), bl.nc);
+		gemm_tile(C, A, B, 0, m, jj, nc, bl, Ap.begin(), Bp.begin());
+	}
+}
+
+/** @copydoc multiply(MatrixView<Elem>, const MatA&, const MatB&, GemmBlocking) */
+template<class Elem, class MatA, class MatB>
+void multiply(Matrix<Elem>& C, const MatA& A, const MatB& B, GemmBlocking bl = GemmBlocking()){
+	multiply(view(C), A, B, bl);
+}
+
+/** @copydoc multiply(MatrixView<Elem>, const MatA&, const MatB&, GemmBlocking) */
+template<class Elem, class MatA, class MatB>
+void multiply(MatrixRC<Elem>& C, const MatA& A, const MatB& B, GemmBlocking bl = GemmBlocking()){
+	multiply(view(C), A, B, bl);
+}
+
+/**
+ * @brief C = A * B on several threads	\n
+ * C is split in tiles of mc rows (B3L2 by default) by up to nc columns,
+ * narrowed so the B panels of all threads together fit in L3,
+ * threads take tiles from a shared counter and compute them like multiply(),
+ * each with its own packed A/B scratch, so threads only write to their own tiles
+ * @param nThreads max n of threads used, 0 means every thread of the pool
+ * @param pool pool running the work, the library wide threadPool() by default
+ */
+template<class Elem, class MatA, class MatB>
+void multiply_parallel(MatrixView<Elem> C, const MatA& A, const MatB& B,
+	size_t nThreads = 0, GemmBlocking bl = GemmBlocking(),
+	ThreadPool& pool = threadPool())
+{
+	assert(A.rows() == C.rows() && B.cols() == C.cols() && A.cols() == B.rows() && "multiply: sizes differ");
+
+	size_t m = C.rows();
+	size_t n = C.cols();
+	if(A.cols() == 0 || m == 0 || n == 0)
+		return multiply(C, A, B, bl);
+	size_t nr = gemmKernel<Elem>().nr;
+	bl.fill<Elem>().normalize(nr);
+	size_t kcMax = std::min(bl.kc, A.cols());
+
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+
+	// every thread packs its own kc x tileCols B panel, they share L3
+	size_t share = cacheInfo().usable(3)/(nThreads*kcMax*sizeof(Elem));
+	size_t tileCols = std::min(std::max(lowerMultiple(share, bl.l1), bl.l1), bl.nc);
+
+	size_t tilesI = (m + bl.mc - 1)/bl.mc;
+	size_t tilesJ = (n + tileCols - 1)/tileCols;
+	size_t tiles = tilesI*tilesJ;
+	nThreads = std::min(nThreads, tiles);
+
+	std::atomic<size_t> next(0);
+	pool.run(nThreads, [&](size_t){
+		varray<Elem> Ap(bl.mc*kcMax);
+		varray<Elem> Bp(tileCols*kcMax);
+		for(size_t t = next++; t < tiles; t = next++){
+			// consecutive tiles share the B panel columns
+			size_t jj = (t / tilesI)*tileCols;
+			size_t ii = (t % tilesI)*bl.mc;
+			size_t nc = std::min(upperMultiple(n - jj, nr), tileCols);
+			gemm_tile(C, A, B, ii, std::min(ii + bl.mc, m), jj, nc,
+				bl, Ap.begin(), Bp.begin());
+		}
+	});
+}
+
+/** @copydoc multiply_parallel(MatrixView<Elem>, const MatA&, const MatB&, size_t, GemmBlocking, ThreadPool&) */
+template<class Elem, class MatA, class MatB>
+void multiply_parallel(Matrix<Elem>& C, const MatA& A, const MatB& B,
+	size_t nThreads = 0, GemmBlocking bl = GemmBlocking(),
+	ThreadPool& pool = threadPool())
+{
+	multiply_parallel(view(C), A, B, nThreads, bl, pool);
+}
+
+/** @copydoc multiply_parallel(MatrixView<Elem>, const MatA&, const MatB&, size_t, GemmBlocking, ThreadPool&) */
+template<class Elem, class MatA, class MatB>
+void multiply_parallel(MatrixRC<Elem>& C, const MatA& A, const MatB& B,
+	size_t nThreads = 0, GemmBlocking bl = GemmBlocking(),
+	ThreadPool& pool = threadPool())
+{
+	multiply_parallel(view(C), A, B, nThreads, bl, pool);
+}
+
+/** @brief C must be row major, the micro-kernel stores rows of C */
+template<class Elem, class MatA, class MatB>
+void multiply(MatrixColMajor<Elem>& C, const MatA& A, const MatB& B, GemmBlocking bl = GemmBlocking()) = delete;
+template<class Elem, class MatA, class MatB>
+void multiply_parallel(MatrixColMajor<Elem>& C, const MatA& A, const MatB& B,
+	size_t nThreads = 0, GemmBlocking bl = GemmBlocking(),
+	ThreadPool& pool = threadPool()) = delete;
+
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#include "Matrix.hpp"
+#include "MatrixView.hpp"
+#include "Dispatch.hpp"
+#include "ThreadPool.hpp"
+
+/** @brief max bytes of a row of a transpose tile, also bounds the in-place scratch tile */
+#define TRANSPOSE_TILE_BYTES (256)
+/** @brief from this many elems the transposes run on the threads of the pool */
+#define TRANSPOSE_PARALLEL_MIN (1 << 18)
+
+namespace gm
+{
+
+/**
+ * @brief dst[j*ldd + i] = src[i*lds + j] for i < rows, j < cols	\n
+ * Squares of L x L elems (L the lanes of a W bytes register) are loaded
+ * a row per register and transposed in registers, log2(L) stages of
+ * 2 input shuffles exchanging the off-diagonal halves of ever smaller
+ * blocks, then stored a column per register. The edges, and elems of
+ * 1 and 2 bytes whose lane shuffles aren't single instructions,
+ * are copied one by one.
+ */
+template<class T, size_t W>
+GM_INLINE void transposeBlockW(T* dst, size_t ldd, const T* src, size_t lds, size_t rows, size_t cols){
+	using V = VecW<T, W>;
+	using Vu = VecWu<T, W>;
+	using M = VecW<LaneInt<T>, W>;
+	const size_t L = W/sizeof(T);
+	const size_t LOG_L = L >= 16 ? 4 : L >= 8 ? 3 : L >= 4 ? 2 : 1;
+	const bool simd = sizeof(T) >= 4;
+	size_t iEnd = simd ? rows/L*L : 0;
+	size_t jEnd = simd ? cols/L*L : 0;
+	// lanes of the first (lo) and second (hi) row of a pair at each stage,
+	// blocks of d = L/2, L/4.. lanes, index >= L picks the second row
+	M lo[LOG_L], hi[LOG_L];
+	unroll(s, LOG_L)
+		unroll(l, L){
+			size_t d = L >> (s + 1);
+			lo[s][l] = (l & d) ? L + l - d : l;
+			hi[s][l] = (l & d) ? L + l : l + d;
+		}
+	for(size_t i = 0; i < iEnd; i += L){
+		for(size_t j = 0; j < jEnd; j += L){
+			V r[L];
+#pragma GCC unroll 16
+			for(size_t l = 0; l < L; ++l)
+				r[l] = *(const Vu*)(src + (i + l)*lds + j);
+#pragma GCC unroll 4
+			for(size_t s = 0; s < LOG_L; ++s){
+				size_t d = L >> (s + 1);
+#pragma GCC unroll 16
+				for(size_t a = 0; a < L; ++a)
+					if(!(a & d)){
+						V x = r[a], y = r[a + d];
+						r[a] = __builtin_shuffle(x, y, lo[s]);
+						r[a + d] = __builtin_shuffle(x, y, hi[s]);
+					}
+			}
+#pragma GCC unroll 16
+			for(size_t l = 0; l < L; ++l)
+				*(Vu*)(dst + (j + l)*ldd + i) = r[l];
+		}
+		for(size_t l = i; l < i + L; ++l)
+			for(size_t j = jEnd; j < cols; ++j)
+				dst[j*ldd + l] = src[l*lds + j];
+	}
+	for(size_t i = iEnd; i < rows; ++i)
+		for(size_t j = 0; j < cols; ++j)
+			dst[j*ldd + i] = src[i*lds + j];
+}
+
+GM_SIMD_KERNEL(void, transposeBlock, (T* dst, size_t ldd, const T* src, size_t lds, size_t rows, size_t cols),
+	(dst, ldd, src, lds, rows, cols))
+
+namespace detail
+{
+
+/** @brief max elems of a side of a transpose tile, 8 to 64 */
+template<class T>
+constexpr size_t transposeTileMax(){
+	return TRANSPOSE_TILE_BYTES/sizeof(T) < 8 ? 8 : TRANSPOSE_TILE_BYTES/sizeof(T) > 64 ? 64 : TRANSPOSE_TILE_BYTES/sizeof(T);
+}
+
+/** @brief elems of a side of a transpose tile: a source and a destination
+ * tile fit in usable(1) (half of L1), a multiple of a cache line,
+ * at most transposeTileMax() */
+template<class T>
+size_t transposeTile(const CacheInfo& ci = cacheInfo()){
+	size_t b = (size_t)std::sqrt(ci.usable(1)/2/sizeof(T));
+	b = lowerMultiple(b, ci.lineElems<T>());
+	return std::min(std::max<size_t>(b, 8), transposeTileMax<T>());
+}
+
+/** @brief fn(t) for the n tile rows, on the pool from TRANSPOSE_PARALLEL_MIN elems */
+template<class Fn>
+void transposeRows(size_t n, size_t elems, size_t nThreads, ThreadPool& pool, const Fn& fn){
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	if(elems < TRANSPOSE_PARALLEL_MIN || nThreads < 2){
+		for(size_t t = 0; t < n; ++t)
+			fn(t);
+		return;
+	}
+	std::atomic<size_t> next(0);
+	pool.run(std::min(nThreads, n), [&](size_t){
+		for(size_t t = next++; t < n; t = next++)
+			fn(t);
+	});
+}
+
+/** @brief d[j*ldd + i] = s[i*lds + j] for the rows x cols elems of s, tile by tile */
+template<class Elem>
+void transposeMem(Elem* d, size_t ldd, const Elem* s, size_t lds, size_t rows, size_t cols,
+	size_t nThreads, ThreadPool& pool)
+{
+	const size_t B = transposeTile<Elem>();
+	transposeRows((rows + B - 1)/B, rows*cols, nThreads, pool, [&](size_t t){
+		size_t i = t*B;
+		size_t r = std::min(B, rows - i);
+		for(size_t j = 0; j < cols; j += B)
+			transposeBlock(d + j*ldd + i, ldd, s + i*lds + j, lds, r, std::min(B, cols - j));
+	});
+}
+
+/** @brief memory of dst = transpose of the memory of src */
+template<class Elem>
+void transposeMem(Matrix<Elem>& dst, const Matrix<Elem>& src, size_t nThreads, ThreadPool& pool){
+	transposeMem(dst.mem().begin(), dst.sizeMem(), src.mem().cbegin(), src.sizeMem(),
+		src.size(), src.size(), nThreads, pool);
+}
+
+/**
+ * @brief Transposes the memory of M in place, tile pairs swapped through
+ * a tile of scratch: (I, J) to scratch, (J, I) to (I, J), scratch to (J, I)
+ */
+template<class Elem>
+void transposeMemInPlace(Matrix<Elem>& M, size_t nThreads, ThreadPool& pool){
+	const size_t n = M.size();
+	const size_t ld = M.sizeMem();
+	const size_t B = transposeTile<Elem>();
+	Elem* a = M.mem().begin();
+	transposeRows((n + B - 1)/B, n*n, nThreads, pool, [&](size_t t){
+		// at most 16 KiB (64 x 64 floats), 8 KiB (32 x 32) for doubles
+		alignas(64) Elem tmp[transposeTileMax<Elem>()*transposeTileMax<Elem>()];
+		size_t i = t*B;
+		size_t rows = std::min(B, n - i);
+		for(size_t j = i; j < n; j += B){
+			size_t cols = std::min(B, n - j);
+			// tmp holds the transpose of (I, J), cols x rows
+			transposeBlock(tmp, B, a + i*ld + j, ld, rows, cols);
+			if(j != i)
+				transposeBlock(a + i*ld + j, ld, a + j*ld + i, ld, cols, rows);
+			for(size_t r = 0; r < cols; ++r)
+				memcpy(a + (j + r)*ld + i, tmp + r*B, rows*sizeof(Elem));
+		}
+	});
+}
+
+}
+
+/**
+ * @brief dst = src^T, dst and src are different matrices of the same size	\n
+ * Tiles sized by transposeTile() to keep a source and a destination tile
+ * in L1 are read and written by transposeBlock():
+ * every cache line is loaded and stored whole, at the speed of a copy.
+ * Tile rows are spread over the pool from TRANSPOSE_PARALLEL_MIN elems.
+ * ```cpp
+	gm::transpose(At, A);
+ * ```
+ */
+template<class Elem>
+void transpose(Matrix<Elem>& dst, const Matrix<Elem>& src,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(dst.size() == src.size() && &dst != &src && "transpose: sizes differ or same matrix");
+	detail::transposeMem(dst, src, nThreads, pool);
+}
+
+/** @copydoc transpose(Matrix<Elem>&, const Matrix<Elem>&, size_t, ThreadPool&) */
+template<class Elem>
+void transpose(MatrixColMajor<Elem>& dst, const MatrixColMajor<Elem>& src,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(dst.size() == src.size() && &dst != &src && "transpose: sizes differ or same matrix");
+	detail::transposeMem<Elem>(dst, src, nThreads, pool);
+}
+
+/**
+ * @brief dst = src^T for row major views of any shape, dst is src.cols() x src.rows()	\n
+ * A Matrix, a MatrixRC or blocks of them, see MatrixView. dst and src don't overlap.
+ * ```cpp
+	gm::MatrixRC<double> X(n, 8), Xt(8, n);
+	gm::transpose(gm::view(Xt), gm::view(X));
+ * ```
+ */
+template<class Elem, class SrcElem>
+void transpose(MatrixView<Elem> dst, MatrixView<SrcElem> src,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	static_assert(std::is_same<const Elem, const SrcElem>::value, "transpose: elem types differ");
+	assert(dst.rows() == src.cols() && dst.cols() == src.rows() && "transpose: sizes differ");
+	detail::transposeMem<Elem>(dst.data(), dst.ld(), src.data(), src.ld(),
+		src.rows(), src.cols(), nThreads, pool);
+}
+
+/**
+ * @brief dst = src^T, a column major src^T has the memory of src:
+ * a copy of the whole memory, padding included
+ */
+template<class Elem>
+void transpose(MatrixColMajor<Elem>& dst, const Matrix<Elem>& src,
+	size_t = 0, ThreadPool& = threadPool())
+{
+	assert(dst.size() == src.size() && "transpose: sizes differ");
+	memcpy(dst.mem().begin(), src.mem().cbegin(), src.mem().size()*sizeof(Elem));
+}
+
+/** @copydoc transpose(MatrixColMajor<Elem>&, const Matrix<Elem>&, size_t, ThreadPool&) */
+template<class Elem>
+void transpose(Matrix<Elem>& dst, const MatrixColMajor<Elem>& src,
+	size_t = 0, ThreadPool& = threadPool())
+{
+	assert(dst.size() == src.size() && "transpose: sizes differ");
+	memcpy(dst.mem().begin(), src.mem().cbegin(), src.mem().size()*sizeof(Elem));
+}
+
+/**
+ * @brief M = M^T in place, same for Matrix and MatrixColMajor	\n
+ * Tiles above the diagonal are swapped with their mirror through a tile
+ * of scratch, see transpose(Matrix<Elem>&, const Matrix<Elem>&, size_t, ThreadPool&)
+ */
+template<class Elem>
+void transpose(Matrix<Elem>& M, size_t nThreads = 0, ThreadPool& pool = threadPool()){
+	detail::transposeMemInPlace(M, nThreads, pool);
+}
+
+/**
+ * @brief copies A, row major, to the column major M: the memory is
+ * transposed tile by tile instead of strided elem by elem
+ */
+template<class Elem>
+void set(MatrixColMajor<Elem>& M, const Matrix<Elem>& A){
+	assert(M.size() == A.size() && "set: sizes differ");
+	detail::transposeMem<Elem>(M, A, 0, threadPool());
+}
+
+/** @copydoc set(MatrixColMajor<Elem>&, const Matrix<Elem>&) */
+template<class Elem>
+void set(Matrix<Elem>& M, const MatrixColMajor<Elem>& A){
+	assert(M.size() == A.size() && "set: sizes differ");
+	detail::transposeMem<Elem>(M, A, 0, threadPool());
+}
+
+/** @brief copies A to M, same layout, a copy of the whole memory */
+template<class Elem>
+void set(MatrixColMajor<Elem>& M, const MatrixColMajor<Elem>& A){
+	assert(M.size() == A.size() && "set: sizes differ");
+	memcpy(M.mem().begin(), A.mem().cbegin(), A.mem().size()*sizeof(Elem));
+}
+
+}
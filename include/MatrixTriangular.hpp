@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "Matrix.hpp"
+#include "MatrixMultiply.hpp"
+#include "Reduce.hpp"
+#include "ThreadPool.hpp"
+
+/** @brief rows of a block of the triangular solves, the depth of their GEMM updates */
+#define TRSM_NB (192)
+
+namespace gm
+{
+
+/**
+ * @brief Read only view of the transpose of a matrix, at(i, j) is M.at(j, i)	\n
+ * Nothing is copied, the packing of the GEMM kernels reads it like any matrix.
+ * ```cpp
+	gm::trsm_upper(gm::transposed(L), B); // B = L^-T B
+ * ```
+ */
+template<class Mat>
+class MatrixTransposed
+{
+	const Mat& M;
+public:
+	explicit MatrixTransposed(const Mat& M) : M(M) {}
+
+	/** @copydoc Matrix::size() */
+	size_t size() const { return M.size(); }
+	/** @brief n of rows, the columns of M */
+	size_t rows() const { return M.cols(); }
+	/** @brief n of columns, the rows of M */
+	size_t cols() const { return M.rows(); }
+	/** @brief returns M.at(j, i) */
+	auto at(size_t i, size_t j) const -> decltype(M.at(j, i)) { return M.at(j, i); }
+};
+
+/** @brief MatrixTransposed view of M */
+template<class Mat>
+MatrixTransposed<Mat> transposed(const Mat& M){
+	return MatrixTransposed<Mat>(M);
+}
+
+namespace detail
+{
+
+/** @brief pointer to the elem (i, j) of a row major Matrix, j may be M.size() */
+template<class Elem>
+Elem* elemPtr(Matrix<Elem>& M, size_t i, size_t j){
+	return M.mem().begin() + i*M.sizeMem() + j;
+}
+/** @copydoc elemPtr */
+template<class Elem>
+const Elem* elemPtr(const Matrix<Elem>& M, size_t i, size_t j){
+	return M.mem().cbegin() + i*M.sizeMem() + j;
+}
+
+/** @brief width of the column tiles splitting cols for nThreads, a multiple of nr */
+inline size_t tileCols(size_t cols, size_t nThreads, size_t nr, size_t maxCols){
+	size_t tile = upperMultiple((cols + nThreads - 1)/nThreads, nr);
+	return std::max(nr, std::min(tile, maxCols));
+}
+
+/**
+ * @brief B[:, j0:j1] = T^-1 B[:, j0:j1], T lower (forward) or upper (backward)	\n
+ * Blocks of TRSM_NB rows: the rows solved before are applied with one
+ * gemm_update(), then the triangle of the block with row updates.
+ */
+template<class Elem, class MatT>
+void trsmSlab(const MatT& T, const MatrixView<Elem>& B, size_t j0, size_t j1, bool lower, bool unit,
+	const GemmBlocking& bl, Elem* Ap, Elem* Bp)
+{
+	const size_t n = B.rows();
+	const size_t w = j1 - j0;
+	// blocks of whole micro-kernel tiles, see gemm_update()
+	const size_t nb = upperMultiple(TRSM_NB, GEMM_MR);
+	const size_t nBlocks = (n + nb - 1)/nb;
+	for(size_t blk = 0; blk < nBlocks; ++blk){
+		size_t r0 = (lower ? blk : nBlocks - 1 - blk)*nb;
+		size_t r1 = std::min(r0 + nb, n);
+		if(lower && r0)
+			gemm_update(B, T, B, r0, r1, j0, j1, 0, r0, Elem(-1), bl, Ap, Bp);
+		if(!lower && r1 < n)
+			gemm_update(B, T, B, r0, r1, j0, j1, r1, n - r1, Elem(-1), bl, Ap, Bp);
+		for(size_t s = 0; s < r1 - r0; ++s){
+			size_t i = lower ? r0 + s : r1 - 1 - s;
+			Elem* bi = B.row(i) + j0;
+			size_t jBegin = lower ? r0 : i + 1;
+			size_t jEnd = lower ? i : r1;
+			for(size_t j = jBegin; j < jEnd; ++j)
+				axpy(-(Elem)T.at(i, j), B.row(j) + j0, bi, w);
+			if(!unit){
+				Elem inv = Elem(1)/T.at(i, i);
+				for(size_t c = 0; c < w; ++c)
+					bi[c] *= inv;
+			}
+		}
+	}
+}
+
+/** @brief trsmSlab() on column slabs of B spread over the pool */
+template<class Elem, class MatT>
+void trsm(const MatT& T, const MatrixView<Elem>& B, bool lower, bool unit, size_t nThreads, ThreadPool& pool){
+	const size_t n = B.rows();
+	const size_t m = B.cols();
+	assert(T.rows() == n && T.cols() == n && "trsm: sizes differ");
+	if(n == 0 || m == 0)
+		return;
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	size_t nr = gemmKernel<Elem>().nr;
+	GemmBlocking bl;
+	bl.fill<Elem>().normalize(nr);
+	size_t slab = tileCols(m, nThreads, nr, m);
+	size_t slabs = (m + slab - 1)/slab;
+	pool.run(slabs, [&](size_t t){
+		size_t j0 = t*slab;
+		varray<Elem> Ap(bl.mc*bl.kc);
+		varray<Elem> Bp(bl.nc*bl.kc);
+		trsmSlab(T, B, j0, std::min(j0 + slab, m), lower, unit, bl, Ap.begin(), Bp.begin());
+	});
+}
+
+}
+
+/**
+ * @brief B = L^-1 B, solves L X = B for the columns of B, L n x n lower triangular	\n
+ * Blocked on the GEMM kernels (see detail::trsmSlab()), threads take
+ * slabs of columns of B. B is row major with n rows and any n of columns:
+ * a Matrix, a MatrixRC or a MatrixView. L is read with at(), any matrix
+ * or view, only its lower triangle.
+ * @param unit if true the diagonal of L is taken as 1s and not read
+ */
+template<class Elem, class MatL>
+void trsm_lower(const MatL& L, MatrixView<Elem> B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	detail::trsm(L, B, true, unit, nThreads, pool);
+}
+/** @copydoc trsm_lower(const MatL&, MatrixView<Elem>, bool, size_t, ThreadPool&) */
+template<class Elem, class MatL>
+void trsm_lower(const MatL& L, Matrix<Elem>& B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	detail::trsm(L, view(B), true, unit, nThreads, pool);
+}
+/** @copydoc trsm_lower(const MatL&, MatrixView<Elem>, bool, size_t, ThreadPool&) */
+template<class Elem, class MatL>
+void trsm_lower(const MatL& L, MatrixRC<Elem>& B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	detail::trsm(L, view(B), true, unit, nThreads, pool);
+}
+
+/** @brief B = U^-1 B, solves U X = B, U upper triangular, see trsm_lower() */
+template<class Elem, class MatU>
+void trsm_upper(const MatU& U, MatrixView<Elem> B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	detail::trsm(U, B, false, unit, nThreads, pool);
+}
+/** @copydoc trsm_upper(const MatU&, MatrixView<Elem>, bool, size_t, ThreadPool&) */
+template<class Elem, class MatU>
+void trsm_upper(const MatU& U, Matrix<Elem>& B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	detail::trsm(U, view(B), false, unit, nThreads, pool);
+}
+/** @copydoc trsm_upper(const MatU&, MatrixView<Elem>, bool, size_t, ThreadPool&) */
+template<class Elem, class MatU>
+void trsm_upper(const MatU& U, MatrixRC<Elem>& B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	detail::trsm(U, view(B), false, unit, nThreads, pool);
+}
+
+template<class Elem, class MatL>
+void trsm_lower(const MatL& L, MatrixColMajor<Elem>& B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool()) = delete;
+template<class Elem, class MatU>
+void trsm_upper(const MatU& U, MatrixColMajor<Elem>& B, bool unit = false,
+	size_t nThreads = 0, ThreadPool& pool = threadPool()) = delete;
+
+}
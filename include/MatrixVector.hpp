@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+
+#include "Matrix.hpp"
+#include "MatrixView.hpp"
+#include "Reduce.hpp"
+#include "parallel.hpp"
+#include "ThreadPool.hpp"
+
+/** @brief rows of A dotted with x at a time by gemv(), sharing the loads of x */
+#define GEMV_ROWS (4)
+/** @brief columns of A added to y at a time by gemv() of a column major A */
+#define GEMV_COLS (4)
+/** @brief elems of y updated over all the columns before the next ones, stay in L1 */
+#define GEMV_COL_BLOCK (2048)
+/** @brief from this many elems of A gemv() and ger() run on the threads of the pool */
+#define GEMV_PARALLEL_MIN (1 << 17)
+
+namespace gm
+{
+
+/**
+ * @brief y[i] = alpha*dot(A[i, :n], x) + beta*y[i] for the m rows of A,
+ * lda elems from a row to the next	\n
+ * GEMV_ROWS rows at a time with 2 Vec accumulators each: every load of x
+ * feeds GEMV_ROWS FMAs and 2*GEMV_ROWS independent sums hide their latency.
+ * A rows and x at any alignment. y is not read if beta is 0.
+ */
+template<class T, size_t W>
+GM_INLINE void gemvRowsW(const T* A, size_t lda, size_t m, size_t n,
+	const T* x, T alpha, T beta, T* y)
+{
+	using V = VecW<T, W>;
+	using Vu = VecWu<T, W>;
+	const size_t L = W/sizeof(T);
+	size_t i = 0;
+	for(; i + GEMV_ROWS <= m; i += GEMV_ROWS){
+		const T* a = A + i*lda;
+		V acc[GEMV_ROWS][2] = {};
+		size_t j = 0;
+		for(; j + 2*L <= n; j += 2*L){
+			V x0 = *(const Vu*)(x + j);
+			V x1 = *(const Vu*)(x + j + L);
+#pragma GCC unroll 8
+			for(size_t r = 0; r < GEMV_ROWS; ++r){
+				acc[r][0] += *(const Vu*)(a + r*lda + j) * x0;
+				acc[r][1] += *(const Vu*)(a + r*lda + j + L) * x1;
+			}
+		}
+		if(j + L <= n){
+			V x0 = *(const Vu*)(x + j);
+#pragma GCC unroll 8
+			for(size_t r = 0; r < GEMV_ROWS; ++r)
+				acc[r][0] += *(const Vu*)(a + r*lda + j) * x0;
+			j += L;
+		}
+#pragma GCC unroll 8
+		for(size_t r = 0; r < GEMV_ROWS; ++r){
+			V v = acc[r][0] + acc[r][1];
+			T s = 0;
+			unroll(l, L)
+				s += v[l];
+			for(size_t k = j; k < n; ++k)
+				s += a[r*lda + k]*x[k];
+			y[i + r] = beta == T(0) ? alpha*s : alpha*s + beta*y[i + r];
+		}
+	}
+	for(; i < m; ++i){
+		T s = dotW<T, W>(A + i*lda, x, n);
+		y[i] = beta == T(0) ? alpha*s : alpha*s + beta*y[i];
+	}
+}
+
+/**
+ * @brief y[:m] += alpha*(x[0]*A[0, :m] + ... + x[n-1]*A[n-1, :m]),
+ * the n rows of A are the columns of a column major matrix	\n
+ * GEMV_COLS rows of A are added at a time: y is loaded and stored once
+ * per GEMV_COLS FMAs instead of once per axpy.
+ */
+template<class T, size_t W>
+GM_INLINE void gemvColsW(const T* A, size_t lda, size_t m, size_t n,
+	const T* x, T alpha, T* y)
+{
+	using V = VecW<T, W>;
+	using Vu = VecWu<T, W>;
+	const size_t L = W/sizeof(T);
+	size_t j = 0;
+	for(; j + GEMV_COLS <= n; j += GEMV_COLS){
+		const T* a = A + j*lda;
+		V s[GEMV_COLS];
+		T t[GEMV_COLS];
+#pragma GCC unroll 8
+		for(size_t c = 0; c < GEMV_COLS; ++c){
+			t[c] = alpha*x[j + c];
+			s[c] = V{} + t[c];
+		}
+		size_t i = 0;
+		for(; i + L <= m; i += L){
+			V acc = *(Vu*)(y + i);
+#pragma GCC unroll 8
+			for(size_t c = 0; c < GEMV_COLS; ++c)
+				acc += s[c] * *(const Vu*)(a + c*lda + i);
+			*(Vu*)(y + i) = acc;
+		}
+		for(; i < m; ++i)
+			for(size_t c = 0; c < GEMV_COLS; ++c)
+				y[i] += t[c]*a[c*lda + i];
+	}
+	for(; j < n; ++j)
+		axpyW<T, W>(alpha*x[j], A + j*lda, y, m);
+}
+
+GM_SIMD_KERNEL(void, gemvRows, (const T* A, size_t lda, size_t m, size_t n, const T* x, T alpha, T beta, T* y),
+	(A, lda, m, n, x, alpha, beta, y))
+GM_SIMD_KERNEL(void, gemvCols, (const T* A, size_t lda, size_t m, size_t n, const T* x, T alpha, T* y),
+	(A, lda, m, n, x, alpha, y))
+
+namespace detail
+{
+
+/**
+ * @brief fn(i0, i1) on chunks of [0, m) with boundaries on cache lines of y,
+ * one per thread of the pool from GEMV_PARALLEL_MIN elems of A, each on
+ * the same thread every call (ThreadPool::runStatic()) like parallel_for()
+ */
+template<class Elem, class Fn>
+void gemvChunks(size_t m, size_t elems, size_t nThreads, ThreadPool& pool, const Fn& fn){
+	if(m == 0)
+		return;
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	if(elems < GEMV_PARALLEL_MIN || nThreads < 2)
+		return fn(0, m);
+	LineChunks chunks(0, m - 1, nThreads, cacheInfo().lineElems<Elem>());
+	pool.runStatic(chunks.n, [&](size_t c){
+		if(chunks.begin(c) < chunks.endOf(c))
+			fn(chunks.begin(c), chunks.endOf(c));
+	});
+}
+
+/** @brief y = alpha*A*x + beta*y, A m x n row major, lda elems from a row to the next */
+template<class Elem>
+void gemvRowMajor(Elem* y, const Elem* A, size_t lda, size_t m, size_t n, const Elem* x,
+	Elem alpha, Elem beta, size_t nThreads, ThreadPool& pool)
+{
+	gemvChunks<Elem>(m, m*n, nThreads, pool, [&](size_t i0, size_t i1){
+		gemvRows(A + i0*lda, lda, i1 - i0, n, x, alpha, beta, y + i0);
+	});
+}
+
+/**
+ * @brief y = alpha*A*x + beta*y, A m x n column major: column j is
+ * the m elems from A + j*lda	\n
+ * Each thread updates its chunk of y over all the columns,
+ * GEMV_COL_BLOCK elems of y at a time.
+ */
+template<class Elem>
+void gemvColMajor(Elem* y, const Elem* A, size_t lda, size_t m, size_t n, const Elem* x,
+	Elem alpha, Elem beta, size_t nThreads, ThreadPool& pool)
+{
+	gemvChunks<Elem>(m, m*n, nThreads, pool, [&](size_t i0, size_t i1){
+		if(beta == Elem(0))
+			std::fill(y + i0, y + i1, Elem(0));
+		else if(beta != Elem(1))
+			for(size_t i = i0; i < i1; ++i)
+				y[i] *= beta;
+		for(size_t b = i0; b < i1; b += GEMV_COL_BLOCK)
+			gemvCols(A + b, lda, std::min<size_t>(GEMV_COL_BLOCK, i1 - b), n, x, alpha, y + b);
+	});
+}
+
+/** @brief the m rows of A (lda elems apart) += alpha*u[i]*v[:n], rows spread over the pool */
+template<class Elem>
+void gerRows(Elem* A, size_t lda, size_t m, size_t n, const Elem* u, const Elem* v,
+	Elem alpha, size_t nThreads, ThreadPool& pool)
+{
+	gemvChunks<Elem>(m, m*n, nThreads, pool, [&](size_t i0, size_t i1){
+		for(size_t i = i0; i < i1; ++i)
+			axpy(alpha*u[i], v, A + i*lda, n);
+	});
+}
+
+}
+
+/**
+ * @brief y = alpha*A*x + beta*y, matrix-vector product (GEMV)	\n
+ * A row major: y[i] is a dot product of row i with x, GEMV_ROWS rows
+ * at a time sharing the loads of x (see gemvRowsW()). A is streamed once,
+ * so the speed is the memory bandwidth: from GEMV_PARALLEL_MIN elems
+ * chunks of rows run on the threads of the pool. y must not be x,
+ * it is not read if beta is 0.
+ * ```cpp
+	gm::gemv(y, A, x);             // y = A x
+	gm::gemv(r, A, x, -1.0, 1.0);  // r = b - A x, r holding b
+ * ```
+ * @param nThreads max n of threads used, 0 means every thread of the pool
+ * @param pool pool running the work, the library wide threadPool() by default
+ */
+template<class Elem>
+void gemv(varray<Elem>& y, const Matrix<Elem>& A, const varray<Elem>& x,
+	Elem alpha = Elem(1), Elem beta = Elem(0),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(y.size() == A.size() && x.size() == A.size() && &x != &y && "gemv: sizes differ or y is x");
+	detail::gemvRowMajor(y.begin(), A.mem().cbegin(), A.sizeMem(), A.size(), A.size(), x.cbegin(),
+		alpha, beta, nThreads, pool);
+}
+
+/**
+ * @brief y = alpha*A*x + beta*y, A column major	\n
+ * Column AXPY form: y += x[j]*A[:, j] on the columns in memory,
+ * GEMV_COLS of them per load and store of y (see gemvColsW()),
+ * see gemv(varray<Elem>&, const Matrix<Elem>&, const varray<Elem>&, Elem, Elem, size_t, ThreadPool&)
+ */
+template<class Elem>
+void gemv(varray<Elem>& y, const MatrixColMajor<Elem>& A, const varray<Elem>& x,
+	Elem alpha = Elem(1), Elem beta = Elem(0),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(y.size() == A.size() && x.size() == A.size() && &x != &y && "gemv: sizes differ or y is x");
+	detail::gemvColMajor(y.begin(), A.mem().cbegin(), A.sizeMem(), A.size(), A.size(), x.cbegin(),
+		alpha, beta, nThreads, pool);
+}
+
+/**
+ * @brief y = alpha*A*x + beta*y, A a row major view of any shape:
+ * y has A.rows() elems, x A.cols(), see MatrixView
+ */
+template<class Elem, class AElem>
+void gemv(varray<Elem>& y, MatrixView<AElem> A, const varray<Elem>& x,
+	Elem alpha = Elem(1), Elem beta = Elem(0),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	static_assert(std::is_same<const Elem, const AElem>::value, "gemv: elem types differ");
+	assert(y.size() == A.rows() && x.size() == A.cols() && &x != &y && "gemv: sizes differ or y is x");
+	detail::gemvRowMajor<Elem>(y.begin(), A.data(), A.ld(), A.rows(), A.cols(), x.cbegin(),
+		alpha, beta, nThreads, pool);
+}
+
+/** @copydoc gemv(varray<Elem>&, MatrixView<AElem>, const varray<Elem>&, Elem, Elem, size_t, ThreadPool&) */
+template<class Elem>
+void gemv(varray<Elem>& y, const MatrixRC<Elem>& A, const varray<Elem>& x,
+	Elem alpha = Elem(1), Elem beta = Elem(0),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	gemv(y, view(A), x, alpha, beta, nThreads, pool);
+}
+
+/**
+ * @brief A += alpha*x*y^T, rank-1 update (GER)	\n
+ * An axpy per row in memory: A[i, :] += alpha*x[i]*y for a row major A,
+ * A[:, j] += alpha*y[j]*x for a column major one. Bandwidth bound like
+ * gemv(), rows are spread over the pool from GEMV_PARALLEL_MIN elems.
+ * ```cpp
+	gm::ger(A, u, v, -1.0); // A -= u v^T
+ * ```
+ * @param nThreads max n of threads used, 0 means every thread of the pool
+ * @param pool pool running the work, the library wide threadPool() by default
+ */
+template<class Elem>
+void ger(Matrix<Elem>& A, const varray<Elem>& x, const varray<Elem>& y,
+	Elem alpha = Elem(1), size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(x.size() == A.size() && y.size() == A.size() && "ger: sizes differ");
+	detail::gerRows(A.mem().begin(), A.sizeMem(), A.size(), A.size(), x.cbegin(), y.cbegin(),
+		alpha, nThreads, pool);
+}
+
+/** @copydoc ger(Matrix<Elem>&, const varray<Elem>&, const varray<Elem>&, Elem, size_t, ThreadPool&) */
+template<class Elem>
+void ger(MatrixColMajor<Elem>& A, const varray<Elem>& x, const varray<Elem>& y,
+	Elem alpha = Elem(1), size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(x.size() == A.size() && y.size() == A.size() && "ger: sizes differ");
+	detail::gerRows(A.mem().begin(), A.sizeMem(), A.size(), A.size(), y.cbegin(), x.cbegin(),
+		alpha, nThreads, pool);
+}
+
+/** @brief A += alpha*x*y^T, A a row major view of any shape: x has A.rows() elems, y A.cols() */
+template<class Elem>
+void ger(MatrixView<Elem> A, const varray<Elem>& x, const varray<Elem>& y,
+	Elem alpha = Elem(1), size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(x.size() == A.rows() && y.size() == A.cols() && "ger: sizes differ");
+	detail::gerRows(A.data(), A.ld(), A.rows(), A.cols(), x.cbegin(), y.cbegin(),
+		alpha, nThreads, pool);
+}
+
+/** @copydoc ger(MatrixView<Elem>, const varray<Elem>&, const varray<Elem>&, Elem, size_t, ThreadPool&) */
+template<class Elem>
+void ger(MatrixRC<Elem>& A, const varray<Elem>& x, const varray<Elem>& y,
+	Elem alpha = Elem(1), size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	ger(view(A), x, y, alpha, nThreads, pool);
+}
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+
+#include "Matrix.hpp"
+
+namespace gm
+{
+
+/**
+ * @brief Stores values of a rows x cols matrix in a varray, Row Major Order	\n
+ * Rows are padded like the ones of Matrix, each starts on a cache line.
+ */
+template<class Elem>
+class MatrixRC
+{
+protected:
+	varray<Elem> varr;
+	size_t mRows = 0; //!< n of rows
+	size_t mCols = 0; //!< n of elems per row
+	size_t mColsMem = 0; //!< n of elems per row in memory
+
+public:
+	/** @brief n of elems in a vec */
+	size_t vecN() const { return varr.vecN(); }
+	/** @brief Sets the size to rows x cols (if existed: frees old varray pointer) */
+	void alloc(size_t rows, size_t cols){
+		mRows = rows;
+		mCols = cols;
+		mColsMem = calcPadSize<Elem>(cols);
+		varr.alloc(rows*mColsMem);
+	}
+
+	/** @brief Constructor, rows x cols elems */
+	MatrixRC(size_t rows, size_t cols){
+		alloc(rows, cols);
+	}
+	/** @brief empty constructor, call alloc before using */
+	MatrixRC(){}
+
+	/** @brief n of rows */
+	size_t rows() const { return mRows; }
+	/** @brief n of elems in a row */
+	size_t cols() const { return mCols; }
+	/** @brief n of elems in a row in memory, the stride of the rows */
+	size_t sizeMem() const { return mColsMem; }
+	/** @brief n of vec elems in a row in memory */
+	size_t sizeVecMem() const { return mColsMem/vecN(); }
+
+	/** @brief varray of the elems, rows()*sizeMem() with the padding */
+	varray<Elem>& mem(){ return varr; }
+	/** @copydoc mem() */
+	const varray<Elem>& mem() const { return varr; }
+
+	/** @brief returns element memory index at position */
+	size_t indMem(size_t i, size_t j) const {
+		assert(i < mRows && j < mColsMem);
+		return i*mColsMem + j;
+	}
+	/** @brief returns element at position */
+	Elem& at(size_t i, size_t j){
+		return varr.at(indMem(i,j));
+	}
+	/** @copydoc at(size_t,size_t) */
+	const Elem& at(size_t i, size_t j) const {
+		return varr.at(indMem(i,j));
+	}
+
+	/** @brief returns vec<elem> at position, j in vecs */
+	Vec<Elem>& atv(size_t i, size_t j){
+		assert(i < mRows && j < sizeVecMem());
+		return varr.atV(i*sizeVecMem() + j);
+	}
+	/** @copydoc atv(size_t,size_t) */
+	const Vec<Elem>& atv(size_t i, size_t j) const {
+		assert(i < mRows && j < sizeVecMem());
+		return varr.atV(i*sizeVecMem() + j);
+	}
+};
+
+/**
+ * @brief Non owning view of a rows x cols row major matrix in memory,
+ * ld elems from a row to the next	\n
+ * A view of a Matrix, a MatrixRC or a block of them is a pointer and 3 sizes,
+ * nothing is copied: kernels taking views work in place on the storage,
+ * padding included in ld. Copying a view copies the pointer, Elem is
+ * const for read only views.
+ * ```cpp
+	gm::MatrixRC<double> X(n, 8);
+	gm::multiply(gm::view(C, 0, 0, 64, 64), gm::view(A, 0, 0, 64, n), gm::view(B, 0, 0, n, 64));
+	auto tail = gm::view(X).block(16, 0, n - 16, 8);
+ * ```
+ */
+template<class Elem>
+class MatrixView
+{
+	using Base = typename std::remove_const<Elem>::type;
+
+	Elem* ptr = nullptr;
+	size_t mRows = 0, mCols = 0, mLd = 0;
+
+public:
+	MatrixView(){}
+	/** @brief view of rows x cols elems from ptr, rows ld elems apart */
+	MatrixView(Elem* ptr, size_t rows, size_t cols, size_t ld)
+		: ptr(ptr), mRows(rows), mCols(cols), mLd(ld)
+	{
+		assert(cols <= ld || rows <= 1);
+	}
+	/** @brief view of the whole M */
+	MatrixView(Matrix<Base>& M)
+		: MatrixView(M.mem().begin(), M.size(), M.size(), M.sizeMem()) {}
+	/** @copydoc MatrixView(Matrix<Base>&) */
+	MatrixView(MatrixRC<Base>& M)
+		: MatrixView(M.mem().begin(), M.rows(), M.cols(), M.sizeMem()) {}
+	/** @brief read only view of the whole M */
+	template<class E, class = typename std::enable_if<std::is_same<const E, Elem>::value>::type>
+	MatrixView(const Matrix<E>& M)
+		: MatrixView(M.mem().cbegin(), M.size(), M.size(), M.sizeMem()) {}
+	/** @copydoc MatrixView(const Matrix<E>&) */
+	template<class E, class = typename std::enable_if<std::is_same<const E, Elem>::value>::type>
+	MatrixView(const MatrixRC<E>& M)
+		: MatrixView(M.mem().cbegin(), M.rows(), M.cols(), M.sizeMem()) {}
+	/** @brief read only view of v */
+	template<class E, class = typename std::enable_if<std::is_same<const E, Elem>::value>::type>
+	MatrixView(const MatrixView<E>& v)
+		: MatrixView(v.data(), v.rows(), v.cols(), v.ld()) {}
+	/** @brief a view is row major, the memory of a MatrixColMajor is its transpose */
+	MatrixView(const MatrixColMajor<Base>& M) = delete;
+
+	/** @brief n of rows */
+	size_t rows() const { return mRows; }
+	/** @brief n of elems in a row */
+	size_t cols() const { return mCols; }
+	/** @brief n of elems from a row to the next in memory */
+	size_t ld() const { return mLd; }
+	/** @brief first elem */
+	Elem* data() const { return ptr; }
+	/** @brief first elem of row i */
+	Elem* row(size_t i) const { return ptr + i*mLd; }
+
+	/** @brief returns element at position */
+	Elem& at(size_t i, size_t j) const {
+		assert(i < mRows && j < mCols);
+		return ptr[i*mLd + j];
+	}
+
+	/** @brief view of the rows x cols block from (i0, j0), same memory */
+	MatrixView block(size_t i0, size_t j0, size_t rows, size_t cols) const {
+		assert(i0 + rows <= mRows && j0 + cols <= mCols && "MatrixView: block out of the view");
+		return MatrixView(ptr + i0*mLd + j0, rows, cols, mLd);
+	}
+};
+
+/** @brief MatrixView of the whole M */
+template<class Elem>
+MatrixView<Elem> view(Matrix<Elem>& M){ return MatrixView<Elem>(M); }
+/** @copydoc view(Matrix<Elem>&) */
+template<class Elem>
+MatrixView<const Elem> view(const Matrix<Elem>& M){ return MatrixView<const Elem>(M); }
+/** @copydoc view(Matrix<Elem>&) */
+template<class Elem>
+MatrixView<Elem> view(MatrixRC<Elem>& M){ return MatrixView<Elem>(M); }
+/** @copydoc view(Matrix<Elem>&) */
+template<class Elem>
+MatrixView<const Elem> view(const MatrixRC<Elem>& M){ return MatrixView<const Elem>(M); }
+/** @brief v itself */
+template<class Elem>
+MatrixView<Elem> view(MatrixView<Elem> v){ return v; }
+/** @brief a view is row major, the memory of a MatrixColMajor is its transpose */
+template<class Elem>
+void view(const MatrixColMajor<Elem>& M) = delete;
+
+/** @brief MatrixView of the rows x cols block of M from (i0, j0) */
+template<class Mat>
+auto view(Mat&& M, size_t i0, size_t j0, size_t rows, size_t cols) -> decltype(view(M)) {
+	return view(M).block(i0, j0, rows, cols);
+}
+
+}
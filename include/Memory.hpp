@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace gm
+{
+
+/**
+ * @brief Releases a buffer the way al_allloc() got it:
+ * munmap() for mapped memory, delete[] otherwise
+ */
+struct MemDeleter
+{
+	size_t mapped = 0; //!< bytes mapped at the pointer, 0 if it came from new[]
+
+	void operator()(char* p) const {
+#if defined(__linux__)
+		if(mapped){
+			munmap(p, mapped);
+			return;
+		}
+#endif
+		delete[] p;
+	}
+};
+
+/** @brief owner of the memory of varray, vector and Matrix */
+using MemPtr = std::unique_ptr<char[], MemDeleter>;
+
+/** @brief how big buffers are backed */
+enum class HugePages
+{
+	Off, //!< new[], 4 KiB pages
+	Transparent, //!< mmap + madvise(MADV_HUGEPAGE), the kernel backs it with huge pages when it can
+	Explicit, //!< mmap(MAP_HUGETLB) from the reserved pool, Transparent if the pool is empty
+};
+
+/**
+ * @brief Allocation policy of al_allloc()	\n
+ * Buffers of at least threshold bytes are mapped on huge pages,
+ * a TLB entry then covers 2 MiB instead of 4 KiB,
+ * which matters for the strided accesses of big matrices.
+ * Smaller ones, or when mapping fails, come from new[].
+ */
+struct AllocPolicy
+{
+	HugePages huge = HugePages::Transparent;
+	size_t threshold = 4*1024*1024; //!< bytes
+
+	/** @brief reads $GM_HUGEPAGES (off, thp or hugetlb) and $GM_HUGEPAGE_MIN (bytes) */
+	static AllocPolicy fromEnv(){
+		AllocPolicy p;
+		if(const char* env = std::getenv("GM_HUGEPAGES")){
+			if(!std::strcmp(env, "off"))
+				p.huge = HugePages::Off;
+			else if(!std::strcmp(env, "hugetlb"))
+				p.huge = HugePages::Explicit;
+			else
+				p.huge = HugePages::Transparent;
+		}
+		if(const char* env = std::getenv("GM_HUGEPAGE_MIN"))
+			p.threshold = std::strtoull(env, nullptr, 10);
+		return p;
+	}
+};
+
+/** @brief policy used by al_allloc(), may be changed at any time,
+ * affects allocations made afterwards */
+inline AllocPolicy& allocPolicy(){
+	static AllocPolicy policy = AllocPolicy::fromEnv();
+	return policy;
+}
+
+/** @brief size of a (PMD) huge page in bytes, 2 MiB if unknown */
+inline size_t hugePageSize(){
+	static size_t size = []{
+		size_t sz = 0;
+		if(FILE* f = std::fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r")){
+			unsigned long long v;
+			if(std::fscanf(f, "%llu", &v) == 1)
+				sz = v;
+			std::fclose(f);
+		}
+		return sz ? sz : (size_t)2*1024*1024;
+	}();
+	return size;
+}
+
+/**
+ * @brief Maps bytes on huge pages as policy says, the result is page aligned
+ * @return nullptr if huge pages are off or mapping failed
+ */
+inline void* hugeAlloc(size_t bytes, const AllocPolicy& policy, MemPtr& pMem){
+#if defined(__linux__)
+	if(policy.huge == HugePages::Off)
+		return nullptr;
+	size_t huge = hugePageSize();
+	const int prot = PROT_READ | PROT_WRITE;
+	const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+	if(policy.huge == HugePages::Explicit){
+		size_t len = (bytes + huge-1)/huge*huge;
+		void* p = mmap(nullptr, len, prot, flags | MAP_HUGETLB, -1, 0);
+		if(p != MAP_FAILED){
+			pMem = MemPtr((char*)p, MemDeleter{len});
+			return p;
+		}
+	}
+#endif
+
+	// map a huge page more and trim, so the buffer starts on a huge page
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t len = (bytes + page-1)/page*page;
+	char* raw = (char*)mmap(nullptr, len + huge, prot, flags, -1, 0);
+	if(raw == MAP_FAILED)
+		return nullptr;
+	char* p = (char*)(((uintptr_t)raw + huge-1) & ~(uintptr_t)(huge-1));
+	if(p != raw)
+		munmap(raw, p - raw);
+	if(p != raw + huge)
+		munmap(p + len, raw + huge - p);
+#ifdef MADV_HUGEPAGE
+	madvise(p, len, MADV_HUGEPAGE);
+#endif
+	pMem = MemPtr(p, MemDeleter{len});
+	return p;
+#else
+	(void)bytes; (void)policy; (void)pMem;
+	return nullptr;
+#endif
+}
+
+/**
+ * @brief Allocates size bytes aligned into a boundary-bit boundary	\n
+ * Large sizes are mapped on huge pages (see AllocPolicy), else new[]
+ * @param size bytes of your resulting pointer
+ * @param boundary : Power of two no bigger than a page, else the behavior is undefined
+ * @param pMem owner of the memory, don't lose it
+ * @return The aligned pointer
+ */
+inline void* al_allloc(size_t size, size_t boundary, MemPtr & pMem,
+	const AllocPolicy& policy = allocPolicy())
+{
+	if(size >= policy.threshold){
+		if(void* p = hugeAlloc(size, policy, pMem))
+			return p;
+	}
+	size_t bytes = size + boundary-1;
+	// pMem = std::move(std::make_unique<char[]>(bytes)); // Very slow
+	pMem.reset(new char[bytes]);
+	pMem.get_deleter() = MemDeleter{};
+
+	auto tmpPtr = (void*)pMem.get();
+	return std::align(boundary, size, tmpPtr, bytes);
+}
+
+/**
+ * @brief Resizes a mapped buffer of al_allloc() to size bytes, keeping its
+ * contents, with mremap(): the kernel moves the pages instead of copying them
+ * @return The new pointer, page aligned,
+ * nullptr if pMem wasn't mapped or mremap failed, pMem is unchanged then
+ */
+inline void* al_remap(size_t size, MemPtr & pMem){
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+	size_t mapped = pMem.get_deleter().mapped;
+	if(!pMem || !mapped)
+		return nullptr;
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t len = (size + page-1)/page*page;
+	void* p = mremap(pMem.get(), mapped, len, MREMAP_MAYMOVE);
+	if(p == MAP_FAILED)
+		return nullptr;
+#ifdef MADV_HUGEPAGE
+	if(len > mapped)
+		madvise(p, len, MADV_HUGEPAGE);
+#endif
+	pMem.release();
+	pMem = MemPtr((char*)p, MemDeleter{len});
+	return p;
+#else
+	(void)size; (void)pMem;
+	return nullptr;
+#endif
+}
+
+}
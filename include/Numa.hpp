@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "varray.hpp"
+#include "Matrix.hpp"
+#include "parallel.hpp"
+
+// <numaif.h> values, so libnuma isn't needed
+#define GM_MPOL_PREFERRED (1)
+#define GM_MPOL_INTERLEAVE (3)
+#define GM_MPOL_MF_MOVE (1<<1)
+#define GM_MPOL_F_NODE (1<<0)
+#define GM_MPOL_F_ADDR (1<<1)
+
+namespace gm
+{
+
+/**
+ * @brief Where the pages of a varray or Matrix go on a NUMA machine	\n
+ * A page lives on the node of the thread that first writes it, so a
+ * buffer zeroed by the main thread is all on one node and the other
+ * sockets read it remotely. numaPlace() fixes that.
+ */
+enum class NumaPlacement
+{
+	/** each chunk of parallel_for() (Matrix: block of rows) on the node of
+	 * the thread initializing it, for data always split the same way */
+	FirstTouch,
+	/** pages round robin over the nodes, for data every thread reads all of */
+	Interleave,
+};
+
+/** @brief online NUMA nodes, {0} if unknown */
+inline const std::vector<int>& numaOnlineNodes(){
+	static std::vector<int> nodes = []{
+		std::vector<int> n;
+		if(FILE* f = std::fopen("/sys/devices/system/node/online", "r")){
+			// list of ranges: 0-1,4
+			int a, b;
+			while(std::fscanf(f, "%d", &a) == 1){
+				b = a;
+				int c = std::fgetc(f);
+				if(c == '-'){
+					if(std::fscanf(f, "%d", &b) != 1)
+						break;
+					c = std::fgetc(f);
+				}
+				for(int i = a; i <= b; ++i)
+					n.push_back(i);
+				if(c != ',')
+					break;
+			}
+			std::fclose(f);
+		}
+		if(n.empty())
+			n.push_back(0);
+		return n;
+	}();
+	return nodes;
+}
+
+/** @brief n of online NUMA nodes */
+inline size_t numaNodes(){ return numaOnlineNodes().size(); }
+
+/** @brief node of the page holding p, -1 if unknown (not touched yet, no NUMA syscalls) */
+inline int numaNodeOf(const void* p){
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+	int node = -1;
+	if(syscall(SYS_get_mempolicy, &node, nullptr, 0, p, GM_MPOL_F_NODE | GM_MPOL_F_ADDR) == 0)
+		return node;
+#endif
+	(void)p;
+	return -1;
+}
+
+/** @brief node of the cpu running the calling thread, -1 if unknown */
+inline int numaCurrentNode(){
+#if defined(__linux__) && defined(SYS_getcpu)
+	unsigned cpu, node;
+	if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+		return node;
+#endif
+	return -1;
+}
+
+namespace detail
+{
+
+/** @brief the whole pages in [p, p + bytes) */
+inline bool numaPages(const void* p, size_t bytes, uintptr_t& begin, size_t& len){
+#if defined(__linux__)
+	uintptr_t page = sysconf(_SC_PAGESIZE);
+	begin = ((uintptr_t)p + page-1) & ~(page-1);
+	uintptr_t end = ((uintptr_t)p + bytes) & ~(page-1);
+	len = end > begin ? end - begin : 0;
+	return len > 0;
+#else
+	(void)p; (void)bytes; (void)begin; (void)len;
+	return false;
+#endif
+}
+
+/** @brief mbind() the whole pages in [p, p + bytes), moving the ones already touched */
+inline bool numaBind(void* p, size_t bytes, int mode, const unsigned long* mask, size_t maskBits){
+#if defined(__linux__) && defined(SYS_mbind)
+	uintptr_t begin;
+	size_t len;
+	if(!numaPages(p, bytes, begin, len))
+		return false;
+	// the kernel reads maxnode-1 bits
+	return syscall(SYS_mbind, begin, len, mode, mask, maskBits + 1, GM_MPOL_MF_MOVE) == 0;
+#else
+	(void)p; (void)bytes; (void)mode; (void)mask; (void)maskBits;
+	return false;
+#endif
+}
+
+const size_t numaMaskWords = 16; //!< up to 1024 nodes
+
+}
+
+/** @brief Interleaves the pages of [p, p + bytes) over the online nodes
+ * @return false if the kernel refused or there's no whole page */
+inline bool numaInterleave(void* p, size_t bytes){
+	unsigned long mask[detail::numaMaskWords] = {};
+	const size_t wordBits = sizeof(unsigned long)*8;
+	for(int n : numaOnlineNodes())
+		if((size_t)n < detail::numaMaskWords*wordBits)
+			mask[n/wordBits] |= 1ul << (n % wordBits);
+	return detail::numaBind(p, bytes, GM_MPOL_INTERLEAVE, mask, detail::numaMaskWords*wordBits);
+}
+
+/** @brief Prefers the node of the calling thread for [p, p + bytes),
+ * moving there the pages already touched */
+inline bool numaBindLocal(void* p, size_t bytes){
+	int node = numaCurrentNode();
+	const size_t wordBits = sizeof(unsigned long)*8;
+	if(node < 0 || (size_t)node >= detail::numaMaskWords*wordBits)
+		return false;
+	unsigned long mask[detail::numaMaskWords] = {};
+	mask[node/wordBits] |= 1ul << (node % wordBits);
+	return detail::numaBind(p, bytes, GM_MPOL_PREFERRED, mask, detail::numaMaskWords*wordBits);
+}
+
+namespace detail
+{
+
+/** @brief places and sets to value the elems of every chunk of p */
+template<class T>
+void numaPlaceChunks(T* p, const LineChunks& chunks, NumaPlacement placement,
+	const T& value, ThreadPool& pool)
+{
+	bool multiNode = numaNodes() > 1;
+	if(multiNode && placement == NumaPlacement::Interleave)
+		numaInterleave(p + chunks.min, (chunks.end - chunks.min)*sizeof(T));
+
+	pool.runStatic(chunks.n, [&](size_t c){
+		size_t begin = chunks.begin(c);
+		size_t end = chunks.endOf(c);
+		if(begin == end)
+			return;
+		// pages touched before (a reused new[] buffer) are moved
+		if(multiNode && placement == NumaPlacement::FirstTouch)
+			numaBindLocal(p + begin, (end - begin)*sizeof(T));
+		std::fill(p + begin, p + end, value);
+	});
+}
+
+/** @brief node of the first elem of every chunk of p */
+template<class T>
+std::vector<int> numaChunkNodes(const T* p, const LineChunks& chunks){
+	std::vector<int> nodes(chunks.n);
+	for(size_t c = 0; c < chunks.n; ++c)
+		nodes[c] = numaNodeOf(p + chunks.begin(c));
+	return nodes;
+}
+
+}
+
+/**
+ * @brief Places the pages of v on the NUMA nodes and sets every elem to value,
+ * in parallel on the chunks parallel_for() uses with the same nThreads and pool
+ * ```cpp
+	gm::varray<double> X(n);
+	gm::numaPlace(X, gm::NumaPlacement::FirstTouch);
+	auto nodes = gm::numaChunkNodes(X); // node of each chunk
+ * ```
+ * With FirstTouch a chunk is on the node of the thread that ran it here.
+ * Chunk c runs on thread c of the pool (ThreadPool::runStatic()), here and
+ * in parallel_for(), so later loops with the same nThreads, pool and
+ * calling thread read their chunks locally as long as the threads stay on
+ * their node: the pool doesn't pin them, pin the process (taskset,
+ * numactl --cpunodebind) or the threads to keep a node per thread.
+ * Does nothing but the fill on single node machines.
+ */
+template<class T>
+void numaPlace(varray<T>& v, NumaPlacement placement, const T& value = T(),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	if(v.size() == 0)
+		return;
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	detail::numaPlaceChunks(v.begin(), lineChunks(v, 0, v.size()-1, nThreads),
+		placement, value, pool);
+}
+
+/** @brief numaPlace() on blocks of whole rows (columns for MatrixColMajor),
+ * the padding included */
+template<class Elem>
+void numaPlace(Matrix<Elem>& M, NumaPlacement placement, const Elem& value = Elem(),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	if(M.size() == 0)
+		return;
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	varray<Elem>& v = M.mem();
+	detail::numaPlaceChunks(v.begin(), LineChunks(0, v.size()-1, nThreads, M.sizeMem()),
+		placement, value, pool);
+}
+
+/** @brief node each chunk of numaPlace(v, ...) / parallel_for(v, 0, size()-1, ...)
+ * starts on, -1 where unknown */
+template<class T>
+std::vector<int> numaChunkNodes(const varray<T>& v, size_t nThreads = 0,
+	const ThreadPool& pool = threadPool())
+{
+	if(v.size() == 0)
+		return {};
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	return detail::numaChunkNodes(v.cbegin(), lineChunks(v, 0, v.size()-1, nThreads));
+}
+
+/** @brief node each row block of numaPlace(M, ...) starts on, -1 where unknown */
+template<class Elem>
+std::vector<int> numaChunkNodes(const Matrix<Elem>& M, size_t nThreads = 0,
+	const ThreadPool& pool = threadPool())
+{
+	if(M.size() == 0)
+		return {};
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	const varray<Elem>& v = M.mem();
+	return detail::numaChunkNodes(v.cbegin(), LineChunks(0, v.size()-1, nThreads, M.sizeMem()));
+}
+
+}
+
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "varray.hpp"
+#include "Dispatch.hpp"
+
+/** @brief independent Vec accumulators in the reductions,
+ * enough to keep the add/FMA units busy despite their latency */
+#define REDUCE_ACC (8)
+
+namespace gm
+{
+
+/** @brief n of elems before x reaches a W bytes boundary, at most n */
+template<class T, size_t W>
+GM_INLINE size_t simdHead(const T* x, size_t n){
+	size_t mis = (uintptr_t)x % W;
+	size_t head = mis ? (W - mis)/sizeof(T) : 0;
+	return head < n ? head : n;
+}
+
+/** @brief u[0] | ... | u[last], folding halves so it stays in registers */
+template<size_t W>
+GM_INLINE unsigned long long orLanesW(VecW<unsigned long long, W> u){
+	using H = VecW<unsigned long long, W/2>;
+	H lo, hi;
+	__builtin_memcpy(&lo, &u, W/2);
+	__builtin_memcpy(&hi, (const char*)&u + W/2, W/2);
+	return orLanesW<W/2>(lo | hi);
+}
+template<>
+GM_INLINE unsigned long long orLanesW<16>(VecW<unsigned long long, 16> u){
+	return u[0] | u[1];
+}
+
+/** @return true if any lane of the comparison mask m is set */
+template<size_t W, class Mask>
+GM_INLINE bool anyW(Mask m){
+	return orLanesW<W>((VecW<unsigned long long, W>)m) != 0;
+}
+
+/** @brief |x|, x itself for unsigned T, where std::abs is ambiguous */
+template<class T>
+GM_INLINE T absElem(T x, std::false_type){ return std::abs(x); }
+template<class T>
+GM_INLINE T absElem(T x, std::true_type){ return x; }
+
+/** @brief x = |x| lane by lane, unsigned lanes are left as they are */
+template<class V>
+GM_INLINE void absLanes(V& x, std::false_type){ x = x < 0 ? -x : x; }
+template<class V>
+GM_INLINE void absLanes(V&, std::true_type){}
+
+/** @brief x[0] + ... + x[n-1], see sum() */
+template<class T, size_t W>
+GM_INLINE T sumW(const T* x, size_t n){
+	using V = VecW<T, W>;
+	const size_t L = W/sizeof(T);
+	T s = 0;
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		s += x[h];
+
+	V acc[REDUCE_ACC] = {};
+	for(; i + REDUCE_ACC*L <= n; i += REDUCE_ACC*L){
+		const V* xv = (const V*)(x + i);
+		unroll(k, REDUCE_ACC)
+			acc[k] += xv[k];
+	}
+	for(; i + L <= n; i += L)
+		acc[0] += *(const V*)(x + i);
+
+	for(size_t k = 1; k < REDUCE_ACC; ++k)
+		acc[0] += acc[k];
+	unroll(l, L)
+		s += acc[0][l];
+	for(; i < n; ++i)
+		s += x[i];
+	return s;
+}
+
+/** @brief x[0]*y[0] + ... + x[n-1]*y[n-1], see dot() */
+template<class T, size_t W>
+GM_INLINE T dotW(const T* x, const T* y, size_t n){
+	using V = VecW<T, W>;
+	using Vu = VecWu<T, W>;
+	const size_t L = W/sizeof(T);
+	T s = 0;
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		s += x[h]*y[h];
+
+	// x is aligned from here, y only if it has the same misalignment
+	V acc[REDUCE_ACC] = {};
+	for(; i + REDUCE_ACC*L <= n; i += REDUCE_ACC*L){
+		const V* xv = (const V*)(x + i);
+		const Vu* yv = (const Vu*)(y + i);
+		unroll(k, REDUCE_ACC)
+			acc[k] += xv[k]*yv[k];
+	}
+	for(; i + L <= n; i += L)
+		acc[0] += *(const V*)(x + i) * *(const Vu*)(y + i);
+
+	for(size_t k = 1; k < REDUCE_ACC; ++k)
+		acc[0] += acc[k];
+	unroll(l, L)
+		s += acc[0][l];
+	for(; i < n; ++i)
+		s += x[i]*y[i];
+	return s;
+}
+
+/** @brief |x[0]| + ... + |x[n-1]|, see norm1() */
+template<class T, size_t W>
+GM_INLINE T asumW(const T* x, size_t n){
+	using V = VecW<T, W>;
+	const size_t L = W/sizeof(T);
+	T s = 0;
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		s += absElem(x[h], std::is_unsigned<T>());
+
+	V acc[REDUCE_ACC] = {};
+	for(; i + REDUCE_ACC*L <= n; i += REDUCE_ACC*L){
+		const V* xv = (const V*)(x + i);
+		unroll(k, REDUCE_ACC){
+			V a = xv[k];
+			absLanes(a, std::is_unsigned<T>());
+			acc[k] += a;
+		}
+	}
+	for(; i + L <= n; i += L){
+		V a = *(const V*)(x + i);
+		absLanes(a, std::is_unsigned<T>());
+		acc[0] += a;
+	}
+
+	for(size_t k = 1; k < REDUCE_ACC; ++k)
+		acc[0] += acc[k];
+	unroll(l, L)
+		s += acc[0][l];
+	for(; i < n; ++i)
+		s += absElem(x[i], std::is_unsigned<T>());
+	return s;
+}
+
+/**
+ * @brief min (Less = true) or max (Less = false) of x[0..n-1], n > 0	\n
+ * accumulators start as x[0], which doesn't change the result
+ */
+template<class T, size_t W, bool Less>
+GM_INLINE T extremeW(const T* x, size_t n){
+	using V = VecW<T, W>;
+	const size_t L = W/sizeof(T);
+	T m = x[0];
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		m = (Less ? x[h] < m : x[h] > m) ? x[h] : m;
+
+	V acc[REDUCE_ACC];
+	unroll(k, REDUCE_ACC)
+		acc[k] = V{} + m;
+	for(; i + REDUCE_ACC*L <= n; i += REDUCE_ACC*L){
+		const V* xv = (const V*)(x + i);
+		unroll(k, REDUCE_ACC)
+			acc[k] = (Less ? xv[k] < acc[k] : xv[k] > acc[k]) ? xv[k] : acc[k];
+	}
+	for(; i + L <= n; i += L){
+		V xv = *(const V*)(x + i);
+		acc[0] = (Less ? xv < acc[0] : xv > acc[0]) ? xv : acc[0];
+	}
+
+	for(size_t k = 0; k < REDUCE_ACC; ++k)
+		unroll(l, L)
+			m = (Less ? acc[k][l] < m : acc[k][l] > m) ? acc[k][l] : m;
+	for(; i < n; ++i)
+		m = (Less ? x[i] < m : x[i] > m) ? x[i] : m;
+	return m;
+}
+
+template<class T, size_t W>
+GM_INLINE T minW(const T* x, size_t n){ return extremeW<T, W, true>(x, n); }
+
+template<class T, size_t W>
+GM_INLINE T maxW(const T* x, size_t n){ return extremeW<T, W, false>(x, n); }
+
+/** @brief max |x[i]|, see normInf() */
+template<class T, size_t W>
+GM_INLINE T amaxW(const T* x, size_t n){
+	using V = VecW<T, W>;
+	const size_t L = W/sizeof(T);
+	T m = 0;
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		m = std::max<T>(m, absElem(x[h], std::is_unsigned<T>()));
+
+	V acc[REDUCE_ACC] = {};
+	for(; i + REDUCE_ACC*L <= n; i += REDUCE_ACC*L){
+		const V* xv = (const V*)(x + i);
+		unroll(k, REDUCE_ACC){
+			V a = xv[k];
+			absLanes(a, std::is_unsigned<T>());
+			acc[k] = a > acc[k] ? a : acc[k];
+		}
+	}
+	for(; i + L <= n; i += L){
+		V a = *(const V*)(x + i);
+		absLanes(a, std::is_unsigned<T>());
+		acc[0] = a > acc[0] ? a : acc[0];
+	}
+
+	for(size_t k = 0; k < REDUCE_ACC; ++k)
+		unroll(l, L)
+			m = std::max<T>(m, acc[k][l]);
+	for(; i < n; ++i)
+		m = std::max<T>(m, absElem(x[i], std::is_unsigned<T>()));
+	return m;
+}
+
+/** @brief index of the first x[i] == value, n if none, see find() */
+template<class T, size_t W>
+GM_INLINE size_t findW(const T* x, size_t n, T value){
+	// masks OR'ed as integer lanes, OR'ing the masks themselves is scalarized at 512 bits
+	using Bits = VecW<unsigned long long, W>;
+	using V = VecW<T, W>;
+	const size_t L = W/sizeof(T);
+	const size_t U = 4; // Vecs compared per early exit check
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		if(x[h] == value)
+			return h;
+
+	V b = V{} + value;
+	for(; i + U*L <= n; i += U*L){
+		const V* xv = (const V*)(x + i);
+		if(anyW<W>((Bits)(xv[0] == b) | (Bits)(xv[1] == b)
+			| (Bits)(xv[2] == b) | (Bits)(xv[3] == b)))
+			break;
+	}
+	for(; i + L <= n; i += L){
+		if(anyW<W>(*(const V*)(x + i) == b))
+			break;
+	}
+	// the match, if any, is in the next U*L elems
+	for(; i < n; ++i)
+		if(x[i] == value)
+			return i;
+	return n;
+}
+
+/** @brief n of x[i] == value, see count() */
+template<class T, size_t W>
+GM_INLINE size_t countW(const T* x, size_t n, T value){
+	using V = VecW<T, W>;
+	using M = decltype(V{} == V{});
+	using Lane = LaneInt<T>;
+	const size_t L = W/sizeof(T);
+	const size_t B = 255; // Vecs per block, so 8 bit mask lanes don't overflow
+	size_t c = 0;
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		c += x[h] == value;
+
+	V b = V{} + value;
+	while(i + L <= n){
+		size_t blockN = (n - i)/L < B ? (n - i)/L : B;
+		const V* xv = (const V*)(x + i);
+		M acc = {};
+		for(size_t k = 0; k < blockN; ++k)
+			acc -= xv[k] == b; // true lanes are -1
+		unroll(l, L)
+			c += (Lane)acc[l];
+		i += blockN*L;
+	}
+	for(; i < n; ++i)
+		c += x[i] == value;
+	return c;
+}
+
+/** @brief index of the first x[i] != y[i], n if none, see mismatch() */
+template<class T, size_t W>
+GM_INLINE size_t mismatchW(const T* x, const T* y, size_t n){
+	using Bits = VecW<unsigned long long, W>;
+	using V = VecW<T, W>;
+	using Vu = VecWu<T, W>;
+	const size_t L = W/sizeof(T);
+	const size_t U = 4; // Vecs compared per early exit check
+	size_t i = simdHead<T, W>(x, n);
+	for(size_t h = 0; h < i; ++h)
+		if(x[h] != y[h])
+			return h;
+
+	for(; i + U*L <= n; i += U*L){
+		const V* xv = (const V*)(x + i);
+		const Vu* yv = (const Vu*)(y + i);
+		if(anyW<W>((Bits)(xv[0] != yv[0]) | (Bits)(xv[1] != yv[1])
+			| (Bits)(xv[2] != yv[2]) | (Bits)(xv[3] != yv[3])))
+			break;
+	}
+	for(; i + L <= n; i += L){
+		if(anyW<W>(*(const V*)(x + i) != *(const Vu*)(y + i)))
+			break;
+	}
+	// the mismatch, if any, is in the next U*L elems
+	for(; i < n; ++i)
+		if(x[i] != y[i])
+			return i;
+	return n;
+}
+
+/** @brief y[i] += a*x[i], x and y at any alignment, see axpy() */
+template<class T, size_t W>
+GM_INLINE void axpyW(T a, const T* x, T* y, size_t n){
+	using Vu = VecWu<T, W>;
+	const size_t L = W/sizeof(T);
+	size_t i = 0;
+	for(; i + 4*L <= n; i += 4*L){
+		unroll(k, 4)
+			*(Vu*)(y + i + k*L) += a * *(const Vu*)(x + i + k*L);
+	}
+	for(; i + L <= n; i += L)
+		*(Vu*)(y + i) += a * *(const Vu*)(x + i);
+	for(; i < n; ++i)
+		y[i] += a*x[i];
+}
+
+// Dispatched pointer versions, sum(x, n) etc. run the kernels above
+// with the register width of the running cpu
+GM_SIMD_KERNEL(T, sum, (const T* x, size_t n), (x, n))
+GM_SIMD_KERNEL(T, dot, (const T* x, const T* y, size_t n), (x, y, n))
+GM_SIMD_KERNEL(T, asum, (const T* x, size_t n), (x, n))
+GM_SIMD_KERNEL(T, amax, (const T* x, size_t n), (x, n))
+GM_SIMD_KERNEL(T, min, (const T* x, size_t n), (x, n))
+GM_SIMD_KERNEL(T, max, (const T* x, size_t n), (x, n))
+GM_SIMD_KERNEL(size_t, find, (const T* x, size_t n, T value), (x, n, value))
+GM_SIMD_KERNEL(size_t, count, (const T* x, size_t n, T value), (x, n, value))
+GM_SIMD_KERNEL(size_t, mismatch, (const T* x, const T* y, size_t n), (x, y, n))
+GM_SIMD_KERNEL(void, axpy, (T a, const T* x, T* y, size_t n), (a, x, y, n))
+
+/** @brief sum of the elems, summed in a different order than a serial loop */
+template<class T>
+T sum(const varray<T>& v){ return sum(v.cbegin(), v.size()); }
+
+/** @brief dot product, x and y must have the same size */
+template<class T>
+T dot(const varray<T>& x, const varray<T>& y){
+	assert(x.size() == y.size() && "dot: sizes differ");
+	return dot(x.cbegin(), y.cbegin(), x.size());
+}
+
+/** @brief euclidean norm, sqrt(dot(v, v)) */
+template<class T>
+T norm2(const varray<T>& v){ return std::sqrt(dot(v.cbegin(), v.cbegin(), v.size())); }
+
+/** @brief sum of the absolute values */
+template<class T>
+T norm1(const varray<T>& v){ return asum(v.cbegin(), v.size()); }
+
+/** @brief max absolute value, 0 if empty */
+template<class T>
+T normInf(const varray<T>& v){ return amax(v.cbegin(), v.size()); }
+
+/** @brief smallest elem, v must not be empty, NaNs give unspecified results */
+template<class T>
+T min(const varray<T>& v){
+	assert(v.size() > 0 && "min of empty varray");
+	return min(v.cbegin(), v.size());
+}
+
+/** @brief largest elem, v must not be empty, NaNs give unspecified results */
+template<class T>
+T max(const varray<T>& v){
+	assert(v.size() > 0 && "max of empty varray");
+	return max(v.cbegin(), v.size());
+}
+
+/** @brief index of the first elem equal to value, size() if none */
+template<class T>
+size_t find(const varray<T>& v, const T& value){ return find(v.cbegin(), v.size(), value); }
+
+/** @brief n of elems equal to value */
+template<class T>
+size_t count(const varray<T>& v, const T& value){ return count(v.cbegin(), v.size(), value); }
+
+/** @brief true if an elem is equal to value */
+template<class T>
+bool contains(const varray<T>& v, const T& value){ return find(v, value) != v.size(); }
+
+/** @brief index of the first NaN in x[0..n-1], n if none, a scalar pass:
+ * only argmin()/argmax() call it, when min()/max() came out NaN */
+template<class T>
+size_t findNaN(const T* x, size_t n){
+	size_t i = 0;
+	while(i < n && x[i] == x[i])
+		++i;
+	return i;
+}
+
+/** @brief index of the first smallest elem, 0 if empty	\n
+ * vectorized min() then find() of it, both passes stream at full width.
+ * If v has NaNs the index is of the first NaN, or of the smallest
+ * of the other elems, always < size() */
+template<class T>
+size_t argmin(const varray<T>& v){
+	if(v.size() == 0)
+		return 0;
+	size_t i = find(v.cbegin(), v.size(), min(v.cbegin(), v.size()));
+	if(i == v.size())
+		i = findNaN(v.cbegin(), v.size()); // a NaN min() equals nothing
+	assert(i < v.size() && "argmin: index out of range");
+	return i;
+}
+
+/** @brief index of the first largest elem, 0 if empty, see argmin() */
+template<class T>
+size_t argmax(const varray<T>& v){
+	if(v.size() == 0)
+		return 0;
+	size_t i = find(v.cbegin(), v.size(), max(v.cbegin(), v.size()));
+	if(i == v.size())
+		i = findNaN(v.cbegin(), v.size());
+	assert(i < v.size() && "argmax: index out of range");
+	return i;
+}
+
+}
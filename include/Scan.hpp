@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+#include "varray.hpp"
+#include "Dispatch.hpp"
+#include "Reduce.hpp"
+#include "parallel.hpp"
+
+/** @brief from this many elems the scans run on the threads of the pool */
+#define SCAN_PARALLEL_MIN (1 << 18)
+/** @brief up to this many bins histogram() counts in 4 interleaved tables per thread */
+#define HIST_SPLIT_BINS (1 << 12)
+
+namespace gm
+{
+
+/**
+ * @brief y = running sums of x starting at init, y may be x	\n
+ * Every Vec is scanned in registers, log2(lanes) shift and adds,
+ * then offset by the carry of the Vecs before. Elems of 1 byte (and 2 below
+ * AVX-512) are scanned serially, their lane shuffles would be scalarized.
+ * @return init + the sum of x
+ */
+template<class T, size_t W, bool Exclusive>
+GM_INLINE T scanW(const T* x, T* y, size_t n, T init){
+	using V = VecW<T, W>;
+	using Vu = VecWu<T, W>;
+	using M = VecW<LaneInt<T>, W>;
+	const size_t L = W/sizeof(T);
+	const size_t LOG_L = L >= 64 ? 6 : L >= 32 ? 5 : L >= 16 ? 4 : L >= 8 ? 3 : L >= 4 ? 2 : 1;
+	// shuffles moving the lanes up by 1, 2, 4.. with zeros shifted in (index L)
+	M shift[LOG_L];
+	unroll(k, LOG_L)
+		unroll(l, L)
+			shift[k][l] = l >= ((size_t)1 << k) ? l - ((size_t)1 << k) : L;
+	const M last = M{} + (LaneInt<T>)(L - 1);
+	const V zero = {};
+	// lane permutes of 2 bytes need AVX-512, of 1 byte are never single instructions
+	const bool simd = sizeof(T) >= 4 || (sizeof(T) == 2 && W >= 64);
+	size_t i = 0;
+	V carry = V{} + init;
+	for(; simd && i + L <= n; i += L){
+		V v = *(const Vu*)(x + i);
+		unroll(k, LOG_L)
+			v += __builtin_shuffle(v, zero, shift[k]);
+		*(Vu*)(y + i) = carry + (Exclusive ? __builtin_shuffle(v, zero, shift[0]) : v);
+		carry += __builtin_shuffle(v, last);
+	}
+	T c = carry[0];
+	for(; i < n; ++i){
+		T xi = x[i];
+		if(Exclusive){
+			y[i] = c;
+			c += xi;
+		} else {
+			c += xi;
+			y[i] = c;
+		}
+	}
+	return c;
+}
+
+/** @brief y[i] = init + x[0] + ... + x[i], see scanW() */
+template<class T, size_t W>
+GM_INLINE T inclusiveScanW(const T* x, T* y, size_t n, T init){ return scanW<T, W, false>(x, y, n, init); }
+
+/** @brief y[i] = init + x[0] + ... + x[i-1], see scanW() */
+template<class T, size_t W>
+GM_INLINE T exclusiveScanW(const T* x, T* y, size_t n, T init){ return scanW<T, W, true>(x, y, n, init); }
+
+GM_SIMD_KERNEL(T, inclusiveScan, (const T* x, T* y, size_t n, T init), (x, y, n, init))
+GM_SIMD_KERNEL(T, exclusiveScan, (const T* x, T* y, size_t n, T init), (x, y, n, init))
+
+namespace detail
+{
+
+/**
+ * @brief Scan on the threads of pool, reduce then scan:
+ * each chunk sums its x, the chunk offsets are scanned serially,
+ * then each chunk scans its x from its offset
+ */
+template<class T>
+T scanParallel(const T* x, T* y, size_t n, T init, bool exclusive,
+	size_t nThreads, ThreadPool& pool)
+{
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+	if(n < SCAN_PARALLEL_MIN || nThreads < 2)
+		return exclusive ? exclusiveScan(x, y, n, init) : inclusiveScan(x, y, n, init);
+
+	size_t lineElems = std::max(cacheInfo().lineElems<T>(), (size_t)regSize(T));
+	LineChunks chunks(0, n - 1, nThreads, lineElems);
+	std::vector<T> offset(chunks.n + 1);
+	pool.runStatic(chunks.n, [&](size_t c){
+		size_t begin = chunks.begin(c);
+		offset[c + 1] = sum(x + begin, chunks.endOf(c) - begin);
+	});
+	offset[0] = init;
+	for(size_t c = 1; c <= chunks.n; ++c)
+		offset[c] += offset[c - 1];
+
+	pool.runStatic(chunks.n, [&](size_t c){
+		size_t begin = chunks.begin(c);
+		size_t len = chunks.endOf(c) - begin;
+		if(exclusive)
+			exclusiveScan(x + begin, y + begin, len, offset[c]);
+		else
+			inclusiveScan(x + begin, y + begin, len, offset[c]);
+	});
+	return offset[chunks.n];
+}
+
+}
+
+/**
+ * @brief y[i] = init + x[0] + ... + x[i], y may be x	\n
+ * Vectorized, and from SCAN_PARALLEL_MIN elems split on the threads of pool.
+ * Floating points are summed in a different order than a serial loop.
+ * @return init + the sum of x
+ */
+template<class T>
+T inclusive_scan(const T* x, T* y, size_t n, T init = T(),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	return detail::scanParallel(x, y, n, init, false, nThreads, pool);
+}
+
+/** @brief y[i] = init + x[0] + ... + x[i-1], y may be x, see inclusive_scan()
+ * @return init + the sum of x */
+template<class T>
+T exclusive_scan(const T* x, T* y, size_t n, T init = T(),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	return detail::scanParallel(x, y, n, init, true, nThreads, pool);
+}
+
+/** @brief inclusive_scan() of x into y, same size, y may be x */
+template<class T>
+T inclusive_scan(const varray<T>& x, varray<T>& y, T init = T(),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(x.size() == y.size() && "inclusive_scan: sizes differ");
+	return inclusive_scan(x.cbegin(), y.begin(), x.size(), init, nThreads, pool);
+}
+
+/**
+ * @brief exclusive_scan() of x into y, same size, y may be x
+ * ```cpp
+	gm::varray<size_t> offsets(nRows);
+	size_t nnz = gm::exclusive_scan(rowCounts, offsets); // CSR row starts
+ * ```
+ */
+template<class T>
+T exclusive_scan(const varray<T>& x, varray<T>& y, T init = T(),
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	assert(x.size() == y.size() && "exclusive_scan: sizes differ");
+	return exclusive_scan(x.cbegin(), y.begin(), x.size(), init, nThreads, pool);
+}
+
+/**
+ * @brief Counts of binOf(x[i]) in nBins bins, bins >= nBins are not counted	\n
+ * Each thread counts its chunk of x in its own tables, merged at the end,
+ * so threads never share a counter. Up to HIST_SPLIT_BINS bins a thread
+ * spreads consecutive elems over 4 tables: runs of one bin don't wait
+ * on the previous increment of the same counter.
+ * ```cpp
+	auto counts = gm::histogram(bucketIds.cbegin(), n, nBuckets);
+	auto dec = gm::histogram(x.cbegin(), n, 10, [](double v){ return size_t(v*10); });
+ * ```
+ */
+template<class T, class BinOf,
+	class = typename std::enable_if<!std::is_integral<BinOf>::value>::type>
+varray<size_t> histogram(const T* x, size_t n, size_t nBins, BinOf binOf,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	varray<size_t> counts(nBins);
+	std::fill(counts.begin(), counts.end(), 0);
+	if(n == 0 || nBins == 0)
+		return counts;
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+
+	const size_t S = nBins <= HIST_SPLIT_BINS ? 4 : 1;
+	// a table more bin counts the out of range ones, no branch
+	const size_t stride = nBins + 1;
+	LineChunks chunks(0, n - 1, nThreads, std::max(cacheInfo().lineElems<T>(), (size_t)regSize(T)));
+	std::vector<std::unique_ptr<size_t[]>> local(chunks.n);
+	pool.runStatic(chunks.n, [&](size_t c){
+		// allocated by the thread counting in it
+		local[c].reset(new size_t[S*stride]());
+		size_t* cnt = local[c].get();
+		size_t i = chunks.begin(c);
+		size_t end = chunks.endOf(c);
+		// locals, the counter stores could alias captured references
+		const T* xs = x;
+		const size_t nb = nBins;
+		BinOf binOfc = binOf;
+		auto bin = [xs, nb, &binOfc](size_t k){
+			size_t b = binOfc(xs[k]);
+			return b < nb ? b : nb;
+		};
+		if(S == 4){
+			size_t* c1 = cnt + stride;
+			size_t* c2 = cnt + 2*stride;
+			size_t* c3 = cnt + 3*stride;
+			for(; i + 4 <= end; i += 4){
+				++cnt[bin(i)];
+				++c1[bin(i + 1)];
+				++c2[bin(i + 2)];
+				++c3[bin(i + 3)];
+			}
+		}
+		for(; i < end; ++i)
+			++cnt[bin(i)];
+	});
+
+	LineChunks bins(0, nBins - 1, nThreads, cacheInfo().lineElems<size_t>());
+	pool.run(bins.n, [&](size_t c){
+		for(size_t t = 0; t < chunks.n; ++t)
+			for(size_t s = 0; s < S; ++s){
+				const size_t* cnt = local[t].get() + s*stride;
+				for(size_t b = bins.begin(c); b < bins.endOf(c); ++b)
+					counts[b] += cnt[b];
+			}
+	});
+	return counts;
+}
+
+/** @brief Counts of the ids x[i] in nBins bins, ids >= nBins (or < 0) are not counted */
+template<class T>
+varray<size_t> histogram(const T* x, size_t n, size_t nBins,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	static_assert(std::is_integral<T>::value, "histogram: integer ids, or pass a binOf");
+	return histogram(x, n, nBins, [](T id){ return (size_t)id; }, nThreads, pool);
+}
+
+/** @brief histogram() of the ids in v */
+template<class T>
+varray<size_t> histogram(const varray<T>& v, size_t nBins,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	return histogram(v.cbegin(), v.size(), nBins, nThreads, pool);
+}
+
+}
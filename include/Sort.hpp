@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "varray.hpp"
+#include "Dispatch.hpp"
+
+/** @brief below this many elems gm::sort() sorts runs in registers and merges them, above radix passes */
+#define SORT_RADIX_MIN (1024)
+/** @brief from this many elems the register runs of gm::sort() beat std::sort, the padding of
+ * the last block of runs costs more below */
+#define SORT_NETWORK_MIN (64)
+
+namespace gm
+{
+
+namespace detail
+{
+
+/** @brief unsigned integer as wide as T, may alias T */
+template<size_t Bytes> struct SortUint;
+template<> struct SortUint<1> { using type __attribute__((may_alias)) = uint8_t; };
+template<> struct SortUint<2> { using type __attribute__((may_alias)) = uint16_t; };
+template<> struct SortUint<4> { using type __attribute__((may_alias)) = uint32_t; };
+template<> struct SortUint<8> { using type __attribute__((may_alias)) = uint64_t; };
+
+/**
+ * @brief Order preserving map of T to unsigned keys and back	\n
+ * Signed integers get the sign bit flipped, floating points the sign bit
+ * if positive and every bit if negative: -0 sorts before +0, NaNs with
+ * the sign bit set before -inf and the others after +inf.
+ */
+template<class T>
+struct SortKey
+{
+	using U = typename SortUint<sizeof(T)>::type;
+	static const U sign = (U)1 << (sizeof(T)*8 - 1);
+
+	static void toKeys(U* k, size_t n){
+		if(std::is_floating_point<T>::value){
+			for(size_t i = 0; i < n; ++i)
+				k[i] ^= (U)(0 - (k[i] >> (sizeof(T)*8 - 1))) | sign;
+		} else if(std::is_signed<T>::value){
+			for(size_t i = 0; i < n; ++i)
+				k[i] ^= sign;
+		}
+	}
+	static void fromKeys(U* k, size_t n){
+		if(std::is_floating_point<T>::value){
+			for(size_t i = 0; i < n; ++i)
+				k[i] ^= (U)((k[i] >> (sizeof(T)*8 - 1)) - 1) | sign;
+		} else if(std::is_signed<T>::value){
+			for(size_t i = 0; i < n; ++i)
+				k[i] ^= sign;
+		}
+	}
+};
+
+/** @brief compare-exchange without branches, a min and a max */
+template<class U>
+inline void sortCE(U& a, U& b){
+	U lo = a < b ? a : b;
+	U hi = a < b ? b : a;
+	a = lo;
+	b = hi;
+}
+
+/** @brief the 63 compare-exchanges of Batcher's odd-even merge network for 16 */
+struct SortNetwork16
+{
+	uint8_t a[63] = {}, b[63] = {};
+
+	constexpr SortNetwork16(){
+		const size_t N = 16;
+		size_t c = 0;
+		for(size_t p = 1; p < N; p <<= 1)
+			for(size_t d = p; d >= 1; d >>= 1)
+				for(size_t j = d % p; j + d < N; j += 2*d)
+					for(size_t i = 0; i < d && i + j + d < N; ++i)
+						if((i + j)/(2*p) == (i + j + d)/(2*p)){
+							a[c] = i + j;
+							b[c] = i + j + d;
+							++c;
+						}
+	}
+};
+
+/**
+ * @brief Sorts n <= 16 keys with a sorting network, padded to 16 with the max key	\n
+ * The compare-exchanges are branchless min/max, no mispredictions
+ * whatever the order of the input.
+ */
+template<class U>
+inline void sortNetwork16(U* k, size_t n){
+	// constant indices once unrolled, r stays in registers
+	constexpr SortNetwork16 net;
+	U r[16];
+	unroll(i, 16)
+		r[i] = i < n ? k[i] : (U)~(U)0;
+#pragma GCC unroll 63
+	for(size_t c = 0; c < 63; ++c)
+		sortCE(r[net.a[c]], r[net.b[c]]);
+	for(size_t i = 0; i < n; ++i)
+		k[i] = r[i];
+}
+
+/**
+ * @brief Sorts every run of 16 keys of k, the last one n % 16 keys	\n
+ * The SortNetwork16 runs on whole registers: 16 Vecs of L keys hold
+ * L columns of 16 keys, a vector min and max per compare-exchange sorts
+ * all the columns at once, each column is then stored as one run
+ * (which 16 keys make a run doesn't matter to the merges after).
+ * The last block is gathered a run per column and padded with the max key.
+ */
+template<class U, size_t W>
+GM_INLINE void sortRuns16W(U* k, size_t n){
+	using V = VecW<U, W>;
+	using Vu = VecWu<U, W>;
+	const size_t L = W/sizeof(U);
+	constexpr SortNetwork16 net;
+	alignas(64) U buf[16*L];
+	for(size_t base = 0; base < n; base += 16*L){
+		size_t m = std::min(16*L, n - base);
+		V r[16];
+		if(m == 16*L){
+#pragma GCC unroll 16
+			for(size_t i = 0; i < 16; ++i)
+				r[i] = *(const Vu*)(k + base + i*L);
+		} else {
+			for(size_t l = 0; l < L; ++l)
+				for(size_t i = 0; i < 16; ++i)
+					buf[i*L + l] = 16*l + i < m ? k[base + 16*l + i] : (U)~(U)0;
+#pragma GCC unroll 16
+			for(size_t i = 0; i < 16; ++i)
+				r[i] = *(const V*)(buf + i*L);
+		}
+#pragma GCC unroll 63
+		for(size_t c = 0; c < 63; ++c){
+			V a = r[net.a[c]], b = r[net.b[c]];
+			r[net.a[c]] = a < b ? a : b;
+			r[net.b[c]] = a < b ? b : a;
+		}
+#pragma GCC unroll 16
+		for(size_t i = 0; i < 16; ++i)
+			*(V*)(buf + i*L) = r[i];
+		for(size_t l = 0; l*16 < m; ++l)
+			for(size_t i = 0; i < 16 && 16*l + i < m; ++i)
+				k[base + 16*l + i] = buf[i*L + l];
+	}
+}
+
+GM_SIMD_KERNEL(void, sortRuns16, (T* k, size_t n), (k, n))
+
+/**
+ * @brief Merges the sorted runs of run keys of k bottom up, ping-ponging
+ * with tmp (room for n keys), the result in k	\n
+ * Branchless merge: one key out per step, whichever run it came from.
+ */
+template<class U>
+void mergeRuns(U* k, U* tmp, size_t n, size_t run){
+	U* src = k;
+	U* dst = tmp;
+	for(; run < n; run *= 2){
+		for(size_t b = 0; b < n; b += 2*run){
+			size_t i = b, ea = std::min(b + run, n);
+			size_t j = ea, eb = std::min(b + 2*run, n);
+			size_t o = b;
+			while(i < ea && j < eb){
+				U x = src[i], y = src[j];
+				bool t = y < x;
+				dst[o++] = t ? y : x;
+				j += t;
+				i += !t;
+			}
+			while(i < ea)
+				dst[o++] = src[i++];
+			while(j < eb)
+				dst[o++] = src[j++];
+		}
+		std::swap(src, dst);
+	}
+	if(src != k)
+		memcpy(k, src, n*sizeof(U));
+}
+
+/** @brief sortRuns16() then mergeRuns() for n < SORT_RADIX_MIN keys of 4 or 8 bytes */
+template<class U>
+void sortRunsMerge(U* k, size_t n, std::true_type){
+	alignas(64) U tmp[SORT_RADIX_MIN];
+	sortRuns16(k, n);
+	mergeRuns(k, tmp, n, (size_t)16);
+}
+/** @brief std::sort for keys of 1 and 2 bytes, the runs of a Vec would be mostly padding */
+template<class U>
+void sortRunsMerge(U* k, size_t n, std::false_type){
+	std::sort(k, k + n);
+}
+
+/** @brief bits of a radix sort digit, 2^RADIX_BITS buckets fit L1 */
+#define SORT_RADIX_BITS (11)
+
+/**
+ * @brief LSD radix sort of n keys on SORT_RADIX_BITS digits,
+ * tmp has room for n keys	\n
+ * One pass counts every digit, then a scatter pass per digit whose keys
+ * aren't all in one bucket (small ranges skip the high digits).
+ */
+template<class U>
+void radixSort(U* k, U* tmp, size_t n){
+	const size_t B = SORT_RADIX_BITS;
+	const size_t R = (size_t)1 << B;
+	const U mask = (U)(R - 1);
+	const size_t D = (sizeof(U)*8 + B-1)/B;
+	std::unique_ptr<size_t[]> counts(new size_t[D*R]());
+	for(size_t i = 0; i < n; ++i){
+		U key = k[i];
+		unroll(d, D)
+			++counts[d*R + ((key >> B*d) & mask)];
+	}
+
+	U* src = k;
+	U* dst = tmp;
+	for(size_t d = 0; d < D; ++d){
+		size_t* c = &counts[d*R];
+		if(c[(src[0] >> B*d) & mask] == n)
+			continue;
+		size_t pos = 0;
+		for(size_t b = 0; b < R; ++b){
+			size_t cnt = c[b];
+			c[b] = pos;
+			pos += cnt;
+		}
+		for(size_t i = 0; i < n; ++i){
+			U key = src[i];
+			dst[c[(key >> B*d) & mask]++] = key;
+		}
+		std::swap(src, dst);
+	}
+	if(src != k)
+		memcpy(k, src, n*sizeof(U));
+}
+
+}
+
+/**
+ * @brief Sorts x[0, n) ascending, for arithmetic T (not bool or long double)	\n
+ * The elems are mapped in place to unsigned keys with the same order
+ * (see detail::SortKey), sorted, and mapped back:
+ * 8 to 16 with a scalar sorting network; from SORT_NETWORK_MIN to
+ * SORT_RADIX_MIN (4 and 8 bytes elems) runs of 16 sorted by the network
+ * on Vec registers (detail::sortRuns16W()) then merged branchless;
+ * else below SORT_RADIX_MIN with std::sort, above with an LSD radix sort
+ * using n elems of scratch memory.
+ * Floating points sort by their bits: -0 before +0, NaNs at the ends.
+ * ```cpp
+	gm::sort(x, n);
+ * ```
+ * nKey >= n elems are mapped, past n they are padding that may be clobbered,
+ * containers pass their whole Vecs so the mapping loops have no remainder.
+ */
+template<class T>
+void sort(T* x, size_t n, size_t nKey = 0){
+	static_assert(isSimdElem<T>::value, "gm::sort: arithmetic elems only");
+	using Key = detail::SortKey<T>;
+	using U = typename Key::U;
+	if(n < 2)
+		return;
+	if(nKey < n)
+		nKey = n;
+	U* k = (U*)x;
+	Key::toKeys(k, nKey);
+	if(n >= 8 && n <= 16)
+		detail::sortNetwork16(k, n);
+	else if(n < SORT_NETWORK_MIN)
+		std::sort(k, k + n);
+	else if(n < SORT_RADIX_MIN)
+		detail::sortRunsMerge(k, n, std::integral_constant<bool, sizeof(U) >= 4>());
+	else {
+		MemPtr pMem;
+		U* tmp = (U*)al_allloc(n*sizeof(U), CACHE_LINE_SIZE, pMem);
+		detail::radixSort(k, tmp, n);
+	}
+	Key::fromKeys(k, nKey);
+}
+
+/** @brief Sorts the elems ascending, see sort(T*, size_t) */
+template<class T>
+void sort(varray<T>& v){
+	sort(v.begin(), v.size(), v.sizeVMem()*v.vecN());
+}
+
+}
@@ -0,0 +1,488 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace gm
+{
+
+/** @brief Unit of work of the ThreadPool */
+struct PoolTask
+{
+	std::function<void()> fn;
+};
+
+/**
+ * @brief Chase-Lev work stealing deque of tasks	\n
+ * The owner thread push()es and pop()s at the bottom (LIFO, cache warm),
+ * other threads steal() from the top (FIFO, the oldest and biggest work).
+ * Grows when full, old buffers are kept until destruction since a thief
+ * may still be reading them.
+ */
+class WorkDeque
+{
+public:
+	explicit WorkDeque(size_t capacity = 256)
+	{
+		buffers_.emplace_back(new Buffer(capacity));
+		buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+	}
+
+	/** @brief owner only */
+	void push(PoolTask* task){
+		int64_t b = bottom_.load(std::memory_order_relaxed);
+		int64_t t = top_.load(std::memory_order_acquire);
+		Buffer* buf = buffer_.load(std::memory_order_relaxed);
+		if(b - t > (int64_t)buf->capacity - 1)
+			buf = grow(buf, t, b);
+		buf->put(b, task);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom_.store(b + 1, std::memory_order_relaxed);
+	}
+
+	/** @brief owner only @return nullptr if empty */
+	PoolTask* pop(){
+		int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+		Buffer* buf = buffer_.load(std::memory_order_relaxed);
+		bottom_.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top_.load(std::memory_order_relaxed);
+		if(t > b){
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		PoolTask* task = buf->get(b);
+		if(t == b){
+			// last task, race the thieves for it
+			if(!top_.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+				task = nullptr;
+			bottom_.store(b + 1, std::memory_order_relaxed);
+		}
+		return task;
+	}
+
+	/** @brief any thread @return nullptr if empty or lost a race */
+	PoolTask* steal(){
+		int64_t t = top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom_.load(std::memory_order_acquire);
+		if(t >= b)
+			return nullptr;
+		Buffer* buf = buffer_.load(std::memory_order_acquire);
+		PoolTask* task = buf->get(t);
+		if(!top_.compare_exchange_strong(t, t + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return task;
+	}
+
+protected:
+	struct Buffer
+	{
+		size_t capacity; //!< power of two
+		std::unique_ptr<std::atomic<PoolTask*>[]> tasks;
+
+		explicit Buffer(size_t capacity)
+			: capacity(capacity)
+			, tasks(new std::atomic<PoolTask*>[capacity])
+		{}
+		PoolTask* get(int64_t i) const {
+			return tasks[i & (capacity - 1)].load(std::memory_order_relaxed);
+		}
+		void put(int64_t i, PoolTask* task){
+			tasks[i & (capacity - 1)].store(task, std::memory_order_relaxed);
+		}
+	};
+
+	Buffer* grow(Buffer* old, int64_t t, int64_t b){
+		buffers_.emplace_back(new Buffer(old->capacity*2));
+		Buffer* buf = buffers_.back().get();
+		for(int64_t i = t; i < b; ++i)
+			buf->put(i, old->get(i));
+		buffer_.store(buf, std::memory_order_release);
+		return buf;
+	}
+
+	alignas(64) std::atomic<int64_t> top_{0};
+	alignas(64) std::atomic<int64_t> bottom_{0};
+	std::atomic<Buffer*> buffer_;
+	std::vector<std::unique_ptr<Buffer>> buffers_; //!< owner only
+};
+
+/**
+ * @brief Work stealing pool of worker threads, started once and shared by
+ * the library kernels so they don't pay thread creation on every call nor
+ * oversubscribe the machine	\n
+ * Each worker has a WorkDeque: tasks spawned on a worker go to its own
+ * deque, tasks spawned from other threads to a shared queue, idle workers
+ * steal from the shared queue and from the other workers.
+ * Threads waiting for tasks (TaskGroup::wait, run) execute tasks meanwhile,
+ * so fork/join can be nested freely. runStatic() instead sends each index
+ * to a fixed thread, for data that must stay with the same thread.
+ * ```cpp
+	gm::ThreadPool pool(4); // caller + 3 workers
+	pool.run(pool.size(), [&](size_t w){
+		// w-th share of the work
+	});
+	gm::TaskGroup g(pool);
+	g.run([&]{ left(); });
+	right();
+	g.wait();
+ * ```
+ */
+class ThreadPool
+{
+public:
+	/** @param nThreads threads taking part in run(), counting the caller,
+	 * 0 means one per hardware thread available to the process */
+	explicit ThreadPool(size_t nThreads = 0)
+	{
+		if(nThreads == 0)
+			nThreads = hardwareThreads();
+		size_t nWorkers = nThreads - 1;
+		deques_.reserve(nWorkers);
+		for(size_t i = 0; i < nWorkers; ++i){
+			deques_.emplace_back(new WorkDeque());
+			mailboxes_.emplace_back(new Mailbox());
+		}
+		for(size_t i = 0; i < nWorkers; ++i)
+			workers_.emplace_back([this, i]{ work(i); });
+	}
+
+	~ThreadPool(){
+		{
+			std::lock_guard<std::mutex> lock(mtx_);
+			stop_ = true;
+		}
+		cv_.notify_all();
+		for(auto& t : workers_)
+			t.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/** @brief n of threads taking part in run(), the caller included */
+	size_t size() const { return workers_.size() + 1; }
+
+	/** @brief n of hardware threads the process may run on, at least 1 */
+	static size_t hardwareThreads(){
+#if defined(__linux__)
+		cpu_set_t set;
+		if(sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0)
+			return CPU_COUNT(&set);
+#endif
+		size_t n = std::thread::hardware_concurrency();
+		return n ? n : 1;
+	}
+
+	/** @brief Queues fn, on the calling worker's deque if it is one of ours */
+	void submit(std::function<void()> fn){
+		PoolTask* task = new PoolTask{std::move(fn)};
+		WorkerId& id = currentWorker();
+		if(id.pool == this)
+			deques_[id.index]->push(task);
+		else{
+			std::lock_guard<std::mutex> lock(injectMtx_);
+			inject_.push_back(task);
+		}
+		queued_.fetch_add(1);
+		if(sleepers_.load() > 0){
+			std::lock_guard<std::mutex> lock(mtx_);
+			cv_.notify_one();
+		}
+	}
+
+	/** @brief Queues fn for worker only, other threads never take it
+	 * @param worker index of the worker, size() - 1 of them */
+	void submitTo(size_t worker, std::function<void()> fn){
+		PoolTask* task = new PoolTask{std::move(fn)};
+		Mailbox& box = *mailboxes_[worker];
+		{
+			std::lock_guard<std::mutex> lock(box.mtx);
+			box.tasks.push_back(task);
+			box.queued.fetch_add(1);
+		}
+		if(sleepers_.load() > 0){
+			// notify_one could wake another worker than the one it is for
+			std::lock_guard<std::mutex> lock(mtx_);
+			cv_.notify_all();
+		}
+	}
+
+	/** @brief Runs one queued task if any can be found @return false if none */
+	bool tryRunOne(){
+		PoolTask* task = take();
+		if(!task)
+			return false;
+		task->fn();
+		delete task;
+		return true;
+	}
+
+	/**
+	 * @brief Calls fn(i) for i in [0, n), returns when all calls finished	\n
+	 * fn(0) runs on the calling thread, which also runs queued tasks
+	 * while it waits, so run() can be nested inside fn
+	 */
+	void run(size_t n, const std::function<void(size_t)>& fn);
+
+	/**
+	 * @brief Calls fn(i) for i in [0, n) like run(), but fn(i) always runs on
+	 * the same thread: i % size(), 0 the calling thread, t > 0 worker t - 1	\n
+	 * The same n splits data the same way on every call, so what a thread
+	 * touched first (NUMA pages, its caches) is used by that thread again.
+	 * No load balancing: for equal chunks, run() for uneven work.
+	 * Called from a worker of this pool it is run(), the caller being
+	 * one of the workers the indexes would go to.
+	 */
+	void runStatic(size_t n, const std::function<void(size_t)>& fn);
+
+protected:
+	struct WorkerId
+	{
+		ThreadPool* pool = nullptr;
+		size_t index = 0;
+	};
+
+	static WorkerId& currentWorker(){
+		static thread_local WorkerId id;
+		return id;
+	}
+
+	/** @brief tasks of submitTo() for one worker */
+	struct Mailbox
+	{
+		std::mutex mtx;
+		std::deque<PoolTask*> tasks;
+		std::atomic<size_t> queued{0};
+	};
+
+	/** @brief the task of submitTo() for the calling worker, if any */
+	PoolTask* takeMail(size_t index){
+		Mailbox& box = *mailboxes_[index];
+		if(box.queued.load() == 0)
+			return nullptr;
+		std::lock_guard<std::mutex> lock(box.mtx);
+		if(box.tasks.empty())
+			return nullptr;
+		PoolTask* task = box.tasks.front();
+		box.tasks.pop_front();
+		box.queued.fetch_sub(1);
+		return task;
+	}
+
+	/** @brief own mailbox and deque, then the shared queue, then the other workers */
+	PoolTask* take(){
+		WorkerId& id = currentWorker();
+		bool mine = id.pool == this;
+		if(mine)
+			if(PoolTask* mail = takeMail(id.index))
+				return mail;
+		PoolTask* task = nullptr;
+		if(mine)
+			task = deques_[id.index]->pop();
+		if(!task && queued_.load() > 0){
+			std::lock_guard<std::mutex> lock(injectMtx_);
+			if(!inject_.empty()){
+				task = inject_.front();
+				inject_.pop_front();
+			}
+		}
+		if(!task && !deques_.empty() && queued_.load() > 0){
+			size_t n = deques_.size();
+			size_t start = nextVictim() % n;
+			for(size_t k = 0; k < n && !task; ++k){
+				size_t v = (start + k) % n;
+				if(!(mine && v == id.index))
+					task = deques_[v]->steal();
+			}
+		}
+		if(task)
+			queued_.fetch_sub(1);
+		return task;
+	}
+
+	static size_t nextVictim(){
+		static thread_local uint64_t x = 88172645463325252ull
+			^ (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		return x;
+	}
+
+	/** @brief worker loop */
+	void work(size_t index){
+		currentWorker() = WorkerId{this, index};
+		while(true){
+			if(tryRunOne())
+				continue;
+			std::atomic<size_t>& mail = mailboxes_[index]->queued;
+			std::unique_lock<std::mutex> lock(mtx_);
+			sleepers_.fetch_add(1);
+			while(queued_.load() == 0 && mail.load() == 0 && !stop_)
+				cv_.wait(lock);
+			sleepers_.fetch_sub(1);
+			if(stop_ && queued_.load() == 0 && mail.load() == 0)
+				return;
+		}
+	}
+
+	std::vector<std::thread> workers_;
+	std::vector<std::unique_ptr<WorkDeque>> deques_; //!< one per worker
+	std::vector<std::unique_ptr<Mailbox>> mailboxes_; //!< one per worker
+	std::deque<PoolTask*> inject_; //!< tasks submitted from outside the pool
+	std::mutex injectMtx_;
+
+	std::atomic<size_t> queued_{0}; //!< tasks in any queue, not taken yet
+	std::atomic<size_t> sleepers_{0};
+	std::mutex mtx_;
+	std::condition_variable cv_; //!< signals new tasks or stop_
+	bool stop_ = false;
+};
+
+/**
+ * @brief Fork/join group of tasks on a ThreadPool	\n
+ * run() spawns, wait() returns once every spawned task finished, running
+ * queued tasks meanwhile. The first exception thrown by a task is rethrown
+ * by wait().
+ */
+class TaskGroup
+{
+public:
+	explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+	~TaskGroup(){ join(); }
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	/** @brief spawns f() */
+	template<class F>
+	void run(F&& f){
+		pending_.fetch_add(1);
+		pool_.submit(wrap(std::forward<F>(f)));
+	}
+
+	/** @brief spawns f() on the worker of index worker, see ThreadPool::submitTo() */
+	template<class F>
+	void runOn(size_t worker, F&& f){
+		pending_.fetch_add(1);
+		pool_.submitTo(worker, wrap(std::forward<F>(f)));
+	}
+
+	/** @brief waits for the spawned tasks, rethrows the first exception */
+	void wait(){
+		join();
+		if(error_){
+			std::exception_ptr e = error_;
+			error_ = nullptr;
+			std::rethrow_exception(e);
+		}
+	}
+
+protected:
+	/** @brief f() keeping its first exception and counting it done */
+	template<class F>
+	std::function<void()> wrap(F&& f){
+		return [this, f]() mutable {
+			try{
+				f();
+			}catch(...){
+				std::lock_guard<std::mutex> lock(errorMtx_);
+				if(!error_)
+					error_ = std::current_exception();
+			}
+			pending_.fetch_sub(1, std::memory_order_release);
+		};
+	}
+
+	void join(){
+		while(pending_.load(std::memory_order_acquire) != 0){
+			if(!pool_.tryRunOne())
+				std::this_thread::yield();
+		}
+	}
+
+	ThreadPool& pool_;
+	std::atomic<size_t> pending_{0};
+	std::mutex errorMtx_;
+	std::exception_ptr error_;
+};
+
+inline void ThreadPool::run(size_t n, const std::function<void(size_t)>& fn){
+	if(n == 0)
+		return;
+	TaskGroup group(*this);
+	for(size_t i = 1; i < n; ++i)
+		group.run([&fn, i]{ fn(i); });
+	fn(0);
+	group.wait();
+}
+
+inline void ThreadPool::runStatic(size_t n, const std::function<void(size_t)>& fn){
+	if(currentWorker().pool == this)
+		return run(n, fn);
+	if(n == 0)
+		return;
+	TaskGroup group(*this);
+	const size_t threads = size();
+	for(size_t i = 0; i < n; ++i)
+		if(i % threads)
+			group.runOn(i % threads - 1, [&fn, i]{ fn(i); });
+	for(size_t i = 0; i < n; i += threads)
+		fn(i);
+	group.wait();
+}
+
+/**
+ * @brief Pool shared by the library kernels, started on first use	\n
+ * $GM_THREADS sets its size, else one thread per hardware thread
+ */
+inline ThreadPool& threadPool(){
+	static ThreadPool pool([]{
+		const char* env = std::getenv("GM_THREADS");
+		return env ? (size_t)std::strtoul(env, nullptr, 10) : (size_t)0;
+	}());
+	return pool;
+}
+
+/** @brief runs the callables concurrently on pool, returns when all finished */
+template<class... F>
+void parallel_invoke_on(ThreadPool& pool, F&&... fs){
+	TaskGroup group(pool);
+	std::function<void()> tasks[] = {std::function<void()>(std::forward<F>(fs))...};
+	size_t n = sizeof...(F);
+	for(size_t i = 1; i < n; ++i)
+		group.run(tasks[i]);
+	tasks[0]();
+	group.wait();
+}
+
+/** @brief runs the callables concurrently on threadPool(), returns when all finished
+ * ```cpp
+	gm::parallel_invoke([&]{ sortLeft(); }, [&]{ sortRight(); });
+ * ```
+ */
+template<class... F>
+void parallel_invoke(F&&... fs){
+	parallel_invoke_on(threadPool(), std::forward<F>(fs)...);
+}
+
+}
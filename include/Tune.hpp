@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "MatrixMultiply.hpp"
+
+namespace gm
+{
+
+/**
+ * @brief Writes the GemmBlocking::tuned() sizes to the profile,
+ * together with the cacheInfo() they were measured on
+ * @return false if the file couldn't be written
+ */
+inline bool saveTuning(const std::string& path = tuneProfilePath()){
+	std::ofstream out(path);
+	if(!out)
+		return false;
+	const CacheInfo& ci = cacheInfo();
+	out << "# Grimoire tuning profile, written by gm::tune()\n";
+	out << "cache " << ci.lineSize << " " << ci.l1 << " " << ci.l2 << " " << ci.l3 << "\n";
+	auto gemm = [&](const char* type, const GemmBlocking& bl){
+		if(bl.nc || bl.kc || bl.mc || bl.l1)
+			out << "gemm " << type << " " << bl.nc << " " << bl.kc << " " << bl.mc << " " << bl.l1 << "\n";
+	};
+	gemm(tuneTypeName<float>(), GemmBlocking::tuned<float>());
+	gemm(tuneTypeName<double>(), GemmBlocking::tuned<double>());
+	return bool(out);
+}
+
+/** @brief ms per multiply() of A and B into C with the block sizes bl */
+template<class Elem>
+double timeMultiply(Matrix<Elem>& C, const Matrix<Elem>& A, const Matrix<Elem>& B,
+	const GemmBlocking& bl, size_t reps)
+{
+	multiply(C, A, B, bl); // warm up caches and pages
+	auto start = std::chrono::steady_clock::now();
+	for(size_t r = 0; r < reps; ++r)
+		multiply(C, A, B, bl);
+	std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+	return ms.count()/reps;
+}
+
+/**
+ * @brief Times multiply() of n x n matrices for candidate block sizes
+ * around the cache derived ones, one field at a time (kc, mc, nc then l1),
+ * keeps the fastest in GemmBlocking::tuned() and saves the profile,
+ * so later processes load them at their first multiply()
+ * ```cpp
+	gm::tune<double>(); // once per machine, takes a few seconds
+ * ```
+ * @param n size of the matrices timed, should be larger than the blocks
+ * @param path profile file, empty to not save
+ * @param reps multiplications averaged per candidate
+ * @return the fastest block sizes
+ */
+template<class Elem = double>
+GemmBlocking tune(size_t n = 1024, const std::string& path = tuneProfilePath(), size_t reps = 3)
+{
+	Matrix<Elem> A(n), B(n), C(n);
+	randomMatrix(A);
+	randomMatrix(B);
+
+	size_t nr = gemmKernel<Elem>().nr;
+	GemmBlocking::tuned<Elem>() = GemmBlocking();
+	GemmBlocking best;
+	best.fill<Elem>().normalize(nr);
+	double bestMs = timeMultiply(C, A, B, best, reps);
+
+	const double factors[] = {0.5, 0.75, 1.5, 2};
+	size_t GemmBlocking::* fields[] = {
+		&GemmBlocking::kc, &GemmBlocking::mc, &GemmBlocking::nc, &GemmBlocking::l1};
+	for(auto field : fields){
+		size_t base = best.*field;
+		GemmBlocking bestField = best;
+		for(double factor : factors){
+			GemmBlocking cand = best;
+			cand.*field = std::max<size_t>(1, base*factor);
+			cand.normalize(nr);
+			if(cand.*field == base)
+				continue;
+			double ms = timeMultiply(C, A, B, cand, reps);
+			if(ms < bestMs){
+				bestMs = ms;
+				bestField = cand;
+			}
+		}
+		best = bestField;
+	}
+
+	GemmBlocking::tuned<Elem>() = best;
+	if(!path.empty())
+		saveTuning(path);
+	return best;
+}
+
+}
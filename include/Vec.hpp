@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <cstdlib>
+#include <stdlib.h>
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <assert.h>
+#include <exception>
+
+#include "bytes.h"
+#include "CacheInfo.hpp"
+#include "Memory.hpp"
+
+#define unroll(v,n) for(size_t v = 0; v < n; ++v)
+#define unroll2D(vi,ni, vj,nj) unroll(vi,ni)unroll(vj,nj)
+#define vec(varr, _i_) for(size_t _i_ = 0; _i_ < varr.vecN(); ++_i_)
+
+#define gm_vectorized_loop_(v, min,max, _i_, block, _vi_, blockVec)	\
+{ 	\
+	size_t _endVI;		\
+	size_t _beginVI = v.loop(min, max, _endVI);		\
+	for (size_t _i_ = min; _i_ < _beginVI; ++_i_) block		\
+	for (size_t _vi_ = _beginVI/v.vecN(); _vi_ < _endVI; ++_vi_){		\
+    blockVec		\
+    }for (size_t _i_ = _endVI*v.vecN(); _i_ <= max; ++_i_) block		\
+}
+// Example of usage, where A,B,X are gm::varray<>s
+// gm_vectorized_loop_(A, 0,size-1,
+// 	i,  {
+// 		X[i] += A[i] * B[i];
+// 	},
+// 	vi,  {
+// 		X.atV(vi).v += A.atV(vi).v * B.atV(vi).v;
+// 	}
+// )
+
+namespace gm
+{
+
+/**
+ * @class Vec
+ * @brief Vectorized type, performs operations in multiple elements at once
+ * using Vector Extensions from gcc, see the compiler doc
+ *
+ * ```cpp
+	Vec<double> a,b,c;
+	c += a * b; // 4 doubles will be multiplied in one instruction
+	// can be individualy be accessed like Vec<> is an array
+	for(int i = 0; i < VecN(double); ++i)
+		std::cout << c[i] << " ";
+	std::cout << std::endl;
+ * ```
+ * the number of elems in the Vec is regSize(elem) */
+template <typename T>
+using Vec __attribute__ ((vector_size (REG_SZ))) = T;
+
+/**
+ * @union vecp
+ * @brief Union of a Vec<elem> and elem pointers	\n
+ * Used to store arrays to access Vec<elem>s or single elems as needed */
+template<typename elem>
+union pVec
+{
+	Vec<elem>*  v;
+	elem* p;
+
+	const elem& operator[] (size_t i) const {
+		return p[i];
+	}
+	elem& operator[] (size_t i) {
+		return p[i];
+	}
+};
+/**
+ * @brief Calculated padded size
+ * to align the end to a cache line and avoid cache trashing
+ * will be a multiple of the cache line and not a power of two,
+ * line and L1 sizes are the ones probed in cacheInfo()
+ */
+template<typename elem>
+size_t calcPadSize(size_t size, const CacheInfo& ci = cacheInfo()){
+	// a Vec<> never straddles rows, even with lines smaller than a register
+	size_t lineElems = std::max<size_t>(ci.lineElems<elem>(), regSize(elem));
+	// add to make it multiple of cache line (padding)
+	size = upperMultiple(size, lineElems);
+	// make sure size is not a power of two, avoid cache trashing
+	size_t cacheLinesMem = size/lineElems;
+	if(cacheLinesMem >= ci.l1Lines() && isPowerOfTwo(cacheLinesMem))
+		size += lineElems;
+	return size;
+}
+
+}
@@ -12,7 +12,11 @@
 #define alignUp(num, align) \
     (((num) + ((align) - 1)) & ~((align) - 1))
 
-#define REG_SZ (32) // how many bytes in a register
+// how many bytes in a register, Vec<T> width
+// kernels in Dispatch.hpp pick their width at runtime instead
+#ifndef REG_SZ
+#define REG_SZ (32)
+#endif
 
 #define regSize(typename) (REG_SZ/sizeof(typename))
 #define cacheSize(typename) (CACHE_LINE_SIZE/sizeof(typename))
@@ -22,6 +26,8 @@
 	(   (n > 0) && ((n == 0) || ((n & (n - 1)) == 0))   )
 
 
+// Compile time defaults, gm::cacheInfo() (CacheInfo.hpp) has the values
+// probed from the running cpu and the runtime version of the blocks below
 #define CACHE_LINE_SIZE (64) // likwid-topology: Cache line size:	64
 #define L1_LINE_DN (CACHE_LINE_SIZE/sizeof(double)) // how many doubles in a line
 // likwid-topology: Size
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include "varray.hpp"
+#include "ThreadPool.hpp"
+
+namespace gm
+{
+
+/**
+ * @brief Splits the index range [min, max] in n contiguous chunks of about
+ * the same size whose inner boundaries are multiples of lineElems,
+ * so when elem 0 starts a cache line (varray, vector) no two chunks
+ * write to the same line
+ */
+struct LineChunks
+{
+	size_t min; //!< first index
+	size_t end; //!< one past the last index
+	size_t n; //!< n of chunks
+	size_t lineElems; //!< elems per cache line
+
+	LineChunks(size_t min, size_t max, size_t nChunks, size_t lineElems)
+		: min(min), end(max + 1), lineElems(lineElems)
+	{
+		size_t lines = (end - min + lineElems - 1)/lineElems;
+		n = std::max<size_t>(1, std::min(nChunks, lines));
+	}
+
+	/** @brief first index of chunk c */
+	size_t begin(size_t c) const {
+		if(c == 0)
+			return min;
+		if(c >= n)
+			return end;
+		size_t b = upperMultiple(min + (end - min)*c/n, lineElems);
+		return std::min(b, end);
+	}
+	/** @brief one past the last index of chunk c */
+	size_t endOf(size_t c) const { return begin(c + 1); }
+};
+
+/** @brief Chunks of [min, max] of v with boundaries on cache lines,
+ * the split parallel_for uses */
+template<class VArr>
+LineChunks lineChunks(const VArr& v, size_t min, size_t max, size_t nChunks){
+	using elem = typename std::decay<decltype(v[0])>::type;
+	size_t lineElems = std::max(cacheInfo().lineElems<elem>(), v.vecN());
+	return LineChunks(min, max, nChunks, lineElems);
+}
+
+/**
+ * @brief Parallel gm_vectorized_loop_: runs scalarBlock(i) and vecBlock(vi)
+ * over [min, max] (max included) on the threads of a pool	\n
+ * The range is split in one chunk per thread with boundaries on cache
+ * lines (cacheInfo().lineSize), so threads never write to a shared line,
+ * each chunk loops like gm_vectorized_loop_: scalar head, Vecs, scalar tail.
+ * Chunk c always runs on thread c of the pool (ThreadPool::runStatic()),
+ * so the data of a chunk stays with one thread from call to call.
+ * ```cpp
+	gm::parallel_for(A, 0, size-1,
+		[&](size_t i){
+			X[i] += A[i] * B[i];
+		},
+		[&](size_t vi){
+			X.atV(vi) += A.atV(vi) * B.atV(vi);
+		});
+ * ```
+ * @param v varray (or vector) the indexes refer to, for vecN() and the line size
+ * @param nThreads max n of threads used, 0 means every thread of the pool
+ * @param pool pool running the work, the library wide threadPool() by default
+ */
+template<class VArr, class ScalarBlock, class VecBlock>
+void parallel_for(const VArr& v, size_t min, size_t max,
+	ScalarBlock scalarBlock, VecBlock vecBlock,
+	size_t nThreads = 0, ThreadPool& pool = threadPool())
+{
+	if(max < min)
+		return;
+	if(nThreads == 0 || nThreads > pool.size())
+		nThreads = pool.size();
+
+	size_t vecN = v.vecN();
+	LineChunks chunks = lineChunks(v, min, max, nThreads);
+
+	pool.runStatic(chunks.n, [&](size_t c){
+		size_t begin = chunks.begin(c);
+		size_t end = chunks.endOf(c);
+		if(begin == end)
+			return;
+		size_t beginVI = alignUp(begin, vecN);
+		size_t endVI = end/vecN;
+		if(beginVI/vecN >= endVI){
+			for(size_t i = begin; i < end; ++i)
+				scalarBlock(i);
+			return;
+		}
+		for(size_t i = begin; i < beginVI; ++i)
+			scalarBlock(i);
+		for(size_t vi = beginVI/vecN; vi < endVI; ++vi)
+			vecBlock(vi);
+		for(size_t i = endVI*vecN; i < end; ++i)
+			scalarBlock(i);
+	});
+}
+
+}
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <initializer_list>
+#include <type_traits>
+#include <assert.h>
+
+#include "Vec.hpp"
+#include "Growth.hpp"
+
+namespace gm {
+
+	/**
+	 * @brief gm::vector keeping up to N elems inside the object, no allocation	\n
+	 * Past the inline capacity it spills to aligned heap memory like gm::vector
+	 * and grows with Growth. data() is aligned to sizeof(Vec<T>) and the
+	 * capacity is a multiple of vecN() in both cases, so whole Vec<T>s can be
+	 * loaded up to capacity(). Like gm::vector elems are moved with memcpy.
+	 * ```cpp
+		gm::small_vector<int, 8> v; // capacity() 8, no malloc
+		for (int i = 0; i < 8; ++i)
+			v.push_back(i);         // still inline
+		v.push_back(8);             // spills to the heap
+	 * ```
+	 */
+	template <typename T, size_t N, class Growth = Grow1_5x>
+	class small_vector {
+
+		static_assert(N > 0, "small_vector: N must be > 0, use gm::vector for no inline storage");
+
+		public:
+
+			using value_type 					= T;
+			using reference					= T &;
+			using const_reference			= const T &;
+			using pointer						= T *;
+			using const_pointer				= const T *;
+			using iterator						= T *;
+			using const_iterator				= const T *;
+			using reverse_iterator			= std::reverse_iterator<iterator>;
+			using const_reverse_iterator	= std::reverse_iterator<const_iterator>;
+			using difference_type			= ptrdiff_t;
+			using size_type					= size_t;
+
+			/** @brief inline capacity, N rounded up to whole Vec<T>s */
+			static const size_type INLINE_SZ = (N + regSize(T) - 1)/regSize(T)*regSize(T);
+
+			// construct/copy/destroy:
+			small_vector() noexcept : arr_(inl()) {}
+
+			explicit small_vector(size_type n) : small_vector() {
+				resize(n);
+			}
+
+			small_vector(size_type n, const T &val) : small_vector() {
+				resize(n, val);
+			}
+
+			small_vector(const_iterator first, const_iterator last) : small_vector() {
+				assign(first, last);
+			}
+
+			small_vector(std::initializer_list<T> lst) : small_vector() {
+				assign(lst.begin(), lst.end());
+			}
+
+			small_vector(const small_vector &other) : small_vector() {
+				assign(other.cbegin(), other.cend());
+			}
+
+			small_vector(small_vector &&other) noexcept : small_vector() {
+				take(other);
+			}
+
+			~small_vector() = default;
+
+			small_vector & operator = (const small_vector &other) {
+				if (this != &other)
+					assign(other.cbegin(), other.cend());
+				return *this;
+			}
+
+			small_vector & operator = (small_vector &&other) noexcept {
+				if (this != &other) {
+					clear();
+					toInline();
+					take(other);
+				}
+				return *this;
+			}
+
+			small_vector & operator = (std::initializer_list<T> lst) {
+				assign(lst.begin(), lst.end());
+				return *this;
+			}
+
+			void assign(const_iterator first, const_iterator last) {
+				size_type count = last - first;
+				if (count > rsrv_sz_)
+					reallocate(count);
+				if (count)
+					memmove(arr_, first, count * sizeof(T));
+				size_ = count;
+			}
+
+			void assign(size_type count, const T &value) {
+				T val = value;
+				if (count > rsrv_sz_)
+					reallocate(count);
+				for (size_type i = 0; i < count; ++i)
+					arr_[i] = val;
+				size_ = count;
+			}
+
+			void assign(std::initializer_list<T> lst) {
+				assign(lst.begin(), lst.end());
+			}
+
+			// iterators:
+			iterator begin() noexcept { return arr_; }
+			const_iterator begin() const noexcept { return arr_; }
+			const_iterator cbegin() const noexcept { return arr_; }
+			iterator end() noexcept { return arr_ + size_; }
+			const_iterator end() const noexcept { return arr_ + size_; }
+			const_iterator cend() const noexcept { return arr_ + size_; }
+			reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+			const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(cend()); }
+			reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+			const_reverse_iterator crend() const noexcept { return const_reverse_iterator(cbegin()); }
+
+			// capacity:
+			bool empty() const noexcept { return size_ == 0; }
+			size_type size() const noexcept { return size_; }
+			size_type max_size() const noexcept { return MAX_SZ; }
+			size_type capacity() const noexcept { return rsrv_sz_; }
+			/** @brief true while the elems are stored inside the object */
+			bool is_inline() const noexcept { return arr_ == inl(); }
+
+			/** @brief new elems are T() */
+			void resize(size_type sz) {
+				resize(sz, T());
+			}
+
+			void resize(size_type sz, const T &c) {
+				if (sz > size_) {
+					T val = c;
+					if (sz > rsrv_sz_)
+						reallocate(Growth::next(rsrv_sz_, sz, sizeof(T)));
+					for (size_type i = size_; i < sz; ++i)
+						arr_[i] = val;
+				}
+				size_ = sz;
+			}
+
+			void reserve(size_type sz) {
+				if (sz > rsrv_sz_)
+					reallocate(sz);
+			}
+
+			/** @brief back to the inline storage if size() fits it */
+			void shrink_to_fit() {
+				if (is_inline())
+					return;
+				if (size_ <= INLINE_SZ)
+					toInline();
+				else if (size_ < rsrv_sz_)
+					reallocate(size_);
+			}
+
+			// element access
+			reference operator [](size_type idx) { return arr_[idx]; }
+			const_reference operator [](size_type idx) const { return arr_[idx]; }
+
+			reference at(size_type pos) {
+				if (pos < size_)
+					return arr_[pos];
+				else
+					throw std::out_of_range("accessed position is out of range");
+			}
+			const_reference at(size_type pos) const {
+				if (pos < size_)
+					return arr_[pos];
+				else
+					throw std::out_of_range("accessed position is out of range");
+			}
+
+			reference front() { return arr_[0]; }
+			const_reference front() const { return arr_[0]; }
+			reference back() { return arr_[size_ - 1]; }
+			const_reference back() const { return arr_[size_ - 1]; }
+
+			// data access:
+			T * data() noexcept { return arr_; }
+			const T * data() const noexcept { return arr_; }
+
+			/** @brief n of elems in a Vec<> */
+			size_t vecN() const { return regSize(T); }
+			size_type sizeV() const { return size_/vecN(); }
+
+			// modifiers:
+			template <class ... Args> void emplace_back(Args && ... args) {
+				T val(std::forward<Args>(args) ...);
+				if (size_ == rsrv_sz_)
+					grow();
+				arr_[size_] = std::move(val);
+				++size_;
+			}
+
+			void push_back(const T &val) {
+				emplace_back(val);
+			}
+
+			void push_back(T &&val) {
+				emplace_back(std::move(val));
+			}
+
+			void pop_back() {
+				--size_;
+			}
+
+			template <class ... Args> iterator emplace(const_iterator it, Args && ... args) {
+				T val(std::forward<Args>(args) ...);
+				iterator iit = openGap(it - arr_, 1);
+				(*iit) = std::move(val);
+				return iit;
+			}
+
+			iterator insert(const_iterator it, const T &val) {
+				T tval = val;
+				iterator iit = openGap(it - arr_, 1);
+				(*iit) = std::move(tval);
+				return iit;
+			}
+
+			iterator insert(const_iterator it, T &&val) {
+				T tval = std::move(val);
+				iterator iit = openGap(it - arr_, 1);
+				(*iit) = std::move(tval);
+				return iit;
+			}
+
+			iterator insert(const_iterator it, size_type cnt, const T &val) {
+				T tval = val;
+				iterator f = openGap(it - arr_, cnt);
+				for (size_type i = 0; i < cnt; ++i)
+					f[i] = tval;
+				return f;
+			}
+
+			/** @brief first, last must not point into this small_vector,
+			 * integral InputIt is left to insert(it, count, value) */
+			template <class InputIt, class = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+			iterator insert(const_iterator it, InputIt first, InputIt last) {
+				iterator f = openGap(it - arr_, std::distance(first, last));
+				for (iterator iit = f; first != last; ++iit, ++first)
+					(*iit) = *first;
+				return f;
+			}
+
+			iterator insert(const_iterator it, std::initializer_list<T> lst) {
+				return insert(it, lst.begin(), lst.end());
+			}
+
+			iterator erase(const_iterator it) {
+				return erase(it, it + 1);
+			}
+
+			iterator erase(const_iterator first, const_iterator last) {
+				iterator f = arr_ + (first - arr_);
+				if (first == last) return f;
+				memmove(f, last, (size_ - (last - arr_)) * sizeof(T));
+				size_ -= last - first;
+				return f;
+			}
+
+			void swap(small_vector &rhs) noexcept {
+				small_vector tmp(std::move(rhs));
+				rhs = std::move(*this);
+				*this = std::move(tmp);
+			}
+
+			void clear() noexcept {
+				size_ = 0;
+			}
+
+			bool operator == (const small_vector &rhs) const {
+				if (size_ != rhs.size_) return false;
+				for (size_type i = 0; i < size_; ++i)
+					if (arr_[i] != rhs.arr_[i])
+						return false;
+				return true;
+			}
+			bool operator != (const small_vector &rhs) const { return !(*this == rhs); }
+
+			bool operator < (const small_vector &rhs) const {
+				size_type ub = size_ < rhs.size_ ? size_ : rhs.size_;
+				for (size_type i = 0; i < ub; ++i)
+					if (arr_[i] != rhs.arr_[i])
+						return arr_[i] < rhs.arr_[i];
+				return size_ < rhs.size_;
+			}
+			bool operator > (const small_vector &rhs) const { return rhs < *this; }
+			bool operator <= (const small_vector &rhs) const { return !(rhs < *this); }
+			bool operator >= (const small_vector &rhs) const { return !(*this < rhs); }
+
+		protected:
+
+			size_type size_ = 0;
+			size_type rsrv_sz_ = INLINE_SZ;
+			T *arr_; //!< inl() or the heap memory
+			MemPtr ptr_; //!< heap memory, empty while inline, no access
+			alignas(REG_SZ) char inline_[INLINE_SZ * sizeof(T)];
+
+			// Constants
+
+			static const size_type MAX_SZ = 1000000000;
+
+			T * inl() noexcept { return (T*)inline_; }
+			const T * inl() const noexcept { return (const T*)inline_; }
+
+			// Memory manipulation
+
+			/** @brief Makes room for one more elem with Growth */
+			void grow() {
+				reallocate(Growth::next(rsrv_sz_, size_ + 1, sizeof(T)));
+			}
+
+			/** @brief Makes room for cnt elems at pos, growing with Growth,
+			 * size() includes them @return the first of them */
+			iterator openGap(size_type pos, size_type cnt) {
+				if (size_ + cnt > rsrv_sz_)
+					reallocate(Growth::next(rsrv_sz_, size_ + cnt, sizeof(T)));
+				iterator f = arr_ + pos;
+				if (cnt)
+					memmove(f + cnt, f, (size_ - pos) * sizeof(T));
+				size_ += cnt;
+				return f;
+			}
+
+			/** @brief Moves the elems to heap memory for capacity elems, > INLINE_SZ */
+			void reallocate(size_type capacity) {
+				size_t sizeV = alignUp(capacity, vecN()) / vecN();
+				sizeV = calcPadSize<Vec<T>>(sizeV);
+				MemPtr tptr;
+				T* tarr = (T*)al_allloc(sizeV*sizeof(Vec<T>), CACHE_LINE_SIZE, tptr);
+				assert(((uintptr_t)tarr & (sizeof(Vec<T>) -1)) == 0  && "small_vector pointer not aligned to sizeof(Vec<T>) bytes");
+				if (size_)
+					memcpy(tarr, arr_, size_ * sizeof(T));
+				ptr_.swap(tptr);
+				arr_ = tarr;
+				rsrv_sz_ = sizeV*vecN();
+				Growth::onRealloc(size_, rsrv_sz_, sizeof(T), false);
+			}
+
+			/** @brief Moves the elems back inside the object, size_ <= INLINE_SZ */
+			void toInline() noexcept {
+				if (is_inline())
+					return;
+				if (size_)
+					memcpy(inl(), arr_, size_ * sizeof(T));
+				ptr_.reset();
+				arr_ = inl();
+				rsrv_sz_ = INLINE_SZ;
+			}
+
+			/** @brief Takes the elems of other, this is inline and empty,
+			 * other is left inline and empty */
+			void take(small_vector &other) noexcept {
+				if (other.is_inline()) {
+					if (other.size_)
+						memcpy(inl(), other.arr_, other.size_ * sizeof(T));
+				} else {
+					ptr_ = std::move(other.ptr_);
+					arr_ = other.arr_;
+					rsrv_sz_ = other.rsrv_sz_;
+					other.arr_ = other.inl();
+					other.rsrv_sz_ = INLINE_SZ;
+				}
+				size_ = other.size_;
+				other.size_ = 0;
+			}
+	};
+
+}
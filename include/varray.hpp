@@ -9,99 +9,11 @@
 #include <assert.h>
 #include <exception>
 
-#include "bytes.h"
-
-#define unroll(v,n) for(size_t v = 0; v < n; ++v)
-#define unroll2D(vi,ni, vj,nj) unroll(vi,ni)unroll(vj,nj)
-#define vec(varr, _i_) for(size_t _i_ = 0; _i_ < varr.vecN(); ++_i_)
-
-#define gm_vectorized_loop_(v, min,max, _i_, block, _vi_, blockVec)	\
-{ 	\
-	size_t _endVI;		\
-	size_t _beginVI = v.loop(min, max, _endVI);		\
-	for (size_t _i_ = min; _i_ < _beginVI; ++_i_) block		\
-	for (size_t _vi_ = _beginVI/v.vecN(); _vi_ < _endVI; ++_vi_){		\
-    blockVec		\
-    }for (size_t _i_ = _endVI*v.vecN(); _i_ <= max; ++_i_) block		\
-}
-// Example of usage, where A,B,X are gm::varray<>s
-// gm_vectorized_loop_(A, 0,size-1,
-// 	i,  {
-// 		X[i] += A[i] * B[i];
-// 	},
-// 	vi,  {
-// 		X.atV(vi).v += A.atV(vi).v * B.atV(vi).v;
-// 	}
-// )
+#include "Vec.hpp"
 
 namespace gm
 {
 
-/**
- * @class Vec
- * @brief Vectorized type, performs operations in multiple elements at once
- * using Vector Extensions from gcc, see the compiler doc
- *
- * ```cpp
-	Vec<double> a,b,c;
-	c += a * b; // 4 doubles will be multiplied in one instruction
-	// can be individualy be accessed like Vec<> is an array
-	for(int i = 0; i < VecN(double); ++i)
-		std::cout << c[i] << " ";
-	std::cout << std::endl;
- * ```
- * the number of elems in the Vec is regSize(elem) */
-template <typename T>
-using Vec __attribute__ ((vector_size (REG_SZ))) = T;
-
-/**
- * @union vecp
- * @brief Union of a Vec<elem> and elem pointers	\n
- * Used to store arrays to access Vec<elem>s or single elems as needed */
-template<typename elem>
-union pVec
-{
-	Vec<elem>*  v;
-	elem* p;
-
-	const elem& operator[] (size_t i) const {
-		return p[i];
-	}
-	elem& operator[] (size_t i) {
-		return p[i];
-	}
-};
-/**
- * @brief Allocates size*sizeof(elem) and aligns it into a boundary-bit boundary
- * @param ppElement pointer to array (pointer)
- * @param size number of elems in your resulting pointer
- * @param boundary : Power of two, else the behavior is undefined
- * @return The pointer you should free, don't lose it
- */
-void* al_allloc(size_t size, size_t boundary, std::unique_ptr<char[]> & pMem){
-	size_t bytes = size + boundary-1;
-	// pMem = std::move(std::make_unique<char[]>(bytes)); // Very slow
-	pMem.reset(new char[bytes]);
-
-	auto tmpPtr = (void*)pMem.get();
-	return std::align(boundary, size, tmpPtr, bytes);
-}
-/**
- * @brief Calculated padded size
- * to align the end to a cache line and avoid cache trashing
- * will be a multiple of cacheSize(elem) and not a power of two
- */
-template<typename elem>
-size_t calcPadSize(size_t size){
-	// add to make it multiple of cache line (padding)
-	size = alignUp(size, cacheSize(elem));
-	// make sure size is not a power of two, avoid cache trashing
-	size_t cacheLinesMem = size/cacheSize(elem);
-	if(cacheLinesMem >= L1LINE_N && isPowerOfTwo(cacheLinesMem))
-		size += cacheSize(elem);
-	return size;
-}
-
 /**
  * @brief Vectorized array, use this to use Vector Extensions easily	\n
  * Uses dynamic allocated aligned memory. The start of the array is 64 bytes aligned	\n
@@ -133,7 +45,7 @@ protected:
 	size_t size_; //!< n of elems
 	size_t sizeV_; //!< n of Vec<elem>s
 
-	std::unique_ptr<char[]> pointer_; //!< only to store the pointer, no access
+	MemPtr pointer_; //!< only to store the pointer, no access
 public:
 
 	using iterator = elem*;
@@ -150,7 +62,7 @@ public:
 		size_t bytes = sizeVMem*sizeof(Vec<elem>);
 		arr_.v = (Vec<elem>*)al_allloc(bytes, CACHE_LINE_SIZE, pointer_);
 
-		assert((arr_.v & (sizeof(Vec<elem>) -1)) != 0  && "varray pointer not aligned to sizeof(Vec<elem>) bytes");
+		assert(((uintptr_t)arr_.v & (sizeof(Vec<elem>) -1)) == 0  && "varray pointer not aligned to sizeof(Vec<elem>) bytes");
 	}
 
 	/** @brief calculates how may Vec<>s should be allocated in memory */
@@ -168,6 +80,14 @@ public:
 		this->memAlloc(sizeVMem());
 	}
 
+	/** @brief empty constructor, call alloc before using */
+	varray()
+		: size_(0)
+		, sizeV_(0)
+	{
+		arr_.p = nullptr;
+	}
+
 	/** @brief Constructor @param size n of elems in the varray */
 	varray(size_t size)
 		: size_(size)
@@ -185,14 +105,14 @@ public:
 		, sizeV_(other.sizeV_)
 	{
 		this->memAlloc(sizeVMem());
-		std::copy(other.begin(), other.end(), this->begin());
+		std::copy(other.cbegin(), other.cend(), this->begin());
 	}
 
 	// Assignment
 	varray & operator=(const varray & other){
 		varray tmp(other);
 
-		std::swap(*this, tmp);
+		swap(tmp);
 
 		return *this;
 	}
@@ -206,7 +126,7 @@ public:
 	{
 		other.size_ = 0;
 		other.sizeV_ = 0;
-		other.arr_ = nullptr;
+		other.arr_.p = nullptr;
 	}
 
 	// Move assignment
@@ -214,8 +134,40 @@ public:
 	{
 		varray tmp(std::move(other));
 
-		std::swap(*this, tmp);
+		swap(tmp);
+
+		return *this;
+	}
+
+	/** @brief swaps contents with other, no elem is copied */
+	void swap(varray & other) noexcept
+	{
+		std::swap(arr_, other.arr_);
+		std::swap(size_, other.size_);
+		std::swap(sizeV_, other.sizeV_);
+		pointer_.swap(other.pointer_);
+	}
 
+	/** @brief Constructs from an expression of varrays (varrayExpr.hpp),
+	 * evaluated in one vectorized pass */
+	template<class E, class = typename E::is_varray_expr>
+	varray(const E& e)
+		: varray(e.size())
+	{
+		*this = e;
+	}
+
+	/** @brief Evaluates an expression of varrays (varrayExpr.hpp) into this
+	 * in one vectorized pass over atV(), no temporaries are allocated.
+	 * Expressions are elementwise, so this may appear in it (X = X*a + B) */
+	template<class E, class = typename E::is_varray_expr>
+	varray & operator=(const E& e)
+	{
+		assert(e.size() == size_ && "varray expression size differs");
+		for(size_t vi = 0; vi < sizeV_; ++vi)
+			e.atV(vi, arr_.v[vi]);
+		for(size_t i = sizeV_*vecN(); i < size_; ++i)
+			arr_[i] = e.at(i);
 		return *this;
 	}
 
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <type_traits>
+
+#include "varray.hpp"
+
+namespace gm
+{
+
+/**
+ * Expression templates for varray	\n
+ * Arithmetic on varrays (+ - * / and unary -, with scalars too) builds a
+ * lazy expression, evaluated in one vectorized pass when assigned to a
+ * varray, instead of a temporary varray and a memory pass per operator.
+ * ```cpp
+	gm::varray<double> X(n), A(n), B(n), C(n), D(n);
+	X = a*A + B*C - D; // one loop over atV(), no temporaries
+	X += 0.5*A;        // X = X + 0.5*A
+ * ```
+ * Nodes keep references to the varrays, so an expression stored with auto
+ * must not outlive them.
+ */
+
+/** @brief CRTP base of the expression nodes,
+ * a node has size(), atV(vi, out) writing Vec<T> out and at(i) returning T	\n
+ * atV() writes through out, a Vec<T> returned by value changes the ABI
+ * when the vector extension isn't enabled (-Wpsabi) */
+template<class E>
+struct VExpr
+{
+	using is_varray_expr = void; //!< marks the types varray::operator= evaluates
+};
+
+/** @brief Leaf referencing a varray */
+template<class T>
+struct VRef : VExpr<VRef<T>>
+{
+	using value_type = T;
+	const varray<T>& v;
+
+	explicit VRef(const varray<T>& v) : v(v) {}
+
+	size_t size() const { return v.size(); }
+	void atV(size_t vi, Vec<T>& out) const { out = v.atV(vi); }
+	T at(size_t i) const { return v.at(i); }
+};
+
+/** @brief Leaf of a scalar, broadcast to every elem, size() 0 means any size */
+template<class T>
+struct VScalar : VExpr<VScalar<T>>
+{
+	using value_type = T;
+	Vec<T> xv;
+	T x;
+
+	explicit VScalar(T x) : xv(Vec<T>{} + x), x(x) {}
+
+	size_t size() const { return 0; }
+	void atV(size_t, Vec<T>& out) const { out = xv; }
+	T at(size_t) const { return x; }
+};
+
+/** @brief Elementwise Op of two nodes, Op::apply works on T and Vec<T> alike	\n
+ * both sides are read before out is written, out may be an operand (X = B + X) */
+template<class L, class R, class Op>
+struct VBinary : VExpr<VBinary<L, R, Op>>
+{
+	using value_type = typename L::value_type;
+	L l;
+	R r;
+
+	VBinary(const L& l, const R& r) : l(l), r(r) {
+		assert((l.size() == r.size() || !l.size() || !r.size())
+			&& "varray expression sizes differ");
+	}
+
+	size_t size() const { return l.size() ? l.size() : r.size(); }
+	void atV(size_t vi, Vec<value_type>& out) const {
+		Vec<value_type> a, b;
+		l.atV(vi, a);
+		r.atV(vi, b);
+		Op::apply(a, b, out);
+	}
+	value_type at(size_t i) const {
+		value_type x;
+		Op::apply(l.at(i), r.at(i), x);
+		return x;
+	}
+};
+
+/** @brief Elementwise negation of a node */
+template<class E>
+struct VNegate : VExpr<VNegate<E>>
+{
+	using value_type = typename E::value_type;
+	E e;
+
+	explicit VNegate(const E& e) : e(e) {}
+
+	size_t size() const { return e.size(); }
+	void atV(size_t vi, Vec<value_type>& out) const { e.atV(vi, out); out = -out; }
+	value_type at(size_t i) const { return -e.at(i); }
+};
+
+struct VAdd { template<class A> static void apply(const A& a, const A& b, A& out) { out = a + b; } };
+struct VSub { template<class A> static void apply(const A& a, const A& b, A& out) { out = a - b; } };
+struct VMul { template<class A> static void apply(const A& a, const A& b, A& out) { out = a * b; } };
+struct VDiv { template<class A> static void apply(const A& a, const A& b, A& out) { out = a / b; } };
+
+/** @brief Node type of an operand: VRef for varrays, the node itself for expressions */
+template<class X>
+struct VNode { using type = X; };
+template<class T>
+struct VNode<varray<T>> { using type = VRef<T>; };
+
+/** @brief true for the operands the operators accept, varrays and expression nodes */
+template<class X>
+struct isVOperand : std::integral_constant<bool,
+	std::is_base_of<VExpr<typename VNode<X>::type>, typename VNode<X>::type>::value> {};
+
+/** @brief true if a scalar S can be an operand of a T expression:
+ * a floating scalar on an integral varray would be truncated (x * 0.5 == x * 0) */
+template<class S, class T>
+struct isVScalarFor : std::integral_constant<bool,
+	std::is_arithmetic<S>::value && (std::is_floating_point<T>::value || std::is_integral<S>::value)> {};
+
+#define GM_VARRAY_EXPR_SCALAR_ASSERT(S, T)	\
+	static_assert(isVScalarFor<S, T>::value,	\
+		"varray expression: a floating scalar on an integral varray would be truncated, cast it")
+
+template<class X>
+typename VNode<X>::type toVNode(const X& x){ return typename VNode<X>::type(x); }
+
+#define GM_VARRAY_EXPR_OPERATOR(op, Op)	\
+template<class L, class R, class = typename std::enable_if<isVOperand<L>::value && isVOperand<R>::value>::type>	\
+VBinary<typename VNode<L>::type, typename VNode<R>::type, Op>	\
+operator op(const L& l, const R& r){	\
+	return {toVNode(l), toVNode(r)};	\
+}	\
+template<class L, class S, class = typename std::enable_if<isVOperand<L>::value && std::is_arithmetic<S>::value>::type>	\
+VBinary<typename VNode<L>::type, VScalar<typename VNode<L>::type::value_type>, Op>	\
+operator op(const L& l, S s){	\
+	GM_VARRAY_EXPR_SCALAR_ASSERT(S, typename VNode<L>::type::value_type);	\
+	return {toVNode(l), VScalar<typename VNode<L>::type::value_type>(s)};	\
+}	\
+template<class S, class R, class = typename std::enable_if<std::is_arithmetic<S>::value && isVOperand<R>::value>::type>	\
+VBinary<VScalar<typename VNode<R>::type::value_type>, typename VNode<R>::type, Op>	\
+operator op(S s, const R& r){	\
+	GM_VARRAY_EXPR_SCALAR_ASSERT(S, typename VNode<R>::type::value_type);	\
+	return {VScalar<typename VNode<R>::type::value_type>(s), toVNode(r)};	\
+}
+
+GM_VARRAY_EXPR_OPERATOR(+, VAdd)
+GM_VARRAY_EXPR_OPERATOR(-, VSub)
+GM_VARRAY_EXPR_OPERATOR(*, VMul)
+GM_VARRAY_EXPR_OPERATOR(/, VDiv)
+
+#undef GM_VARRAY_EXPR_OPERATOR
+#undef GM_VARRAY_EXPR_SCALAR_ASSERT
+
+template<class E, class = typename std::enable_if<isVOperand<E>::value>::type>
+VNegate<typename VNode<E>::type> operator-(const E& e){
+	return VNegate<typename VNode<E>::type>(toVNode(e));
+}
+
+/** @brief X = X + e, in one pass */
+template<class T, class E, class = typename std::enable_if<isVOperand<E>::value || std::is_arithmetic<E>::value>::type>
+varray<T>& operator+=(varray<T>& x, const E& e){ return x = x + e; }
+
+/** @brief X = X - e, in one pass */
+template<class T, class E, class = typename std::enable_if<isVOperand<E>::value || std::is_arithmetic<E>::value>::type>
+varray<T>& operator-=(varray<T>& x, const E& e){ return x = x - e; }
+
+/** @brief X = X * e, in one pass */
+template<class T, class E, class = typename std::enable_if<isVOperand<E>::value || std::is_arithmetic<E>::value>::type>
+varray<T>& operator*=(varray<T>& x, const E& e){ return x = x * e; }
+
+/** @brief X = X / e, in one pass */
+template<class T, class E, class = typename std::enable_if<isVOperand<E>::value || std::is_arithmetic<E>::value>::type>
+varray<T>& operator/=(varray<T>& x, const E& e){ return x = x / e; }
+
+}
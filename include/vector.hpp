@@ -11,81 +11,26 @@
 #include <memory>
 #include <assert.h>
 #include <exception>
+#include <type_traits>
+#include <new>
 
-#include "bytes.h"
-
-#define unroll(v,n) for(size_t v = 0; v < n; ++v)
-#define unroll2D(vi,ni, vj,nj) unroll(vi,ni)unroll(vj,nj)
-#define vec(varr, _i_) for(size_t _i_ = 0; _i_ < varr.vecN(); ++_i_)
-
-#define gm_vectorized_loop_(v, min,max, _i_, block, _vi_, blockVec)	\
-{ 	\
-	size_t _endVI;		\
-	size_t _beginVI = v.loop(min, max, _endVI);		\
-	for (size_t _i_ = min; _i_ < _beginVI; ++_i_) block		\
-	for (size_t _vi_ = _beginVI/v.vecN(); _vi_ < _endVI; ++_vi_){		\
-    blockVec		\
-    }for (size_t _i_ = _endVI*v.vecN(); _i_ <= max; ++_i_) block		\
-}
-// Example of usage, where A,B,X are gm::varray<>s
-// gm_vectorized_loop_(A, 0,size-1,
-// 	i,  {
-// 		X[i] += A[i] * B[i];
-// 	},
-// 	vi,  {
-// 		X.atv(vi).v += A.atv(vi).v * B.atv(vi).v;
-// 	}
-// )
+#include "Vec.hpp"
+#include "Growth.hpp"
+#include "Reduce.hpp"
+#include "Compact.hpp"
+#include "Sort.hpp"
 
 namespace gm {
 
-	/**
-	 * @class Vec
-	 * @brief Vectorized type, performs operations in multiple elements at once
-	 * using Vector Extensions from gcc, see the compiler doc
-	 *
+	/** @brief tag of the constructors leaving trivial elems uninitialized */
+	struct default_init_t {};
+	/** @copydoc default_init_t
 	 * ```cpp
-		Vec<double> a,b,c;
-		c += a * b; // 4 doubles will be multiplied in one instruction
-		// can be individualy be accessed like Vec<> is an array
-		for(int i = 0; i < VecN(double); ++i)
-			std::cout << c[i] << " ";
-		std::cout << std::endl;
+		gm::vector<char> buf(size, gm::default_init); // no pass over memory
+		file.read(buf.data(), size);
 	 * ```
-	 * the number of elems in the Vec is regSize(elem) */
-	template <typename T>
-	using Vec __attribute__ ((vector_size (REG_SZ))) = T;
-
-	/**
-	 * @brief Allocates size*sizeof(elem) and aligns it into a boundary-bit boundary
-	 * @param ppElement pointer to array (pointer)
-	 * @param size number of elems in your resulting pointer
-	 * @param boundary : Power of two, else the behavior is undefined
-	 * @return The pointer you should free, don't lose it
-	 */
-	void* al_allloc(size_t size, size_t boundary, std::unique_ptr<char[]> & pMem){
-		size_t bytes = size + boundary-1;
-		// pMem = std::move(std::make_unique<char[]>(bytes)); // Very slow
-		pMem.reset(new char[bytes]);
-
-		auto tmpPtr = (void*)pMem.get();
-		return std::align(boundary, size, tmpPtr, bytes);
-	}
-	/**
-	 * @brief Calculated padded size
-	 * to align the end to a cache line and avoid cache trashing
-	 * will be a multiple of cacheSize(elem) and not a power of two
 	 */
-	template<typename elem>
-	size_t calcPadSize(size_t size){
-		// add to make it multiple of cache line (padding)
-		size = alignUp(size, cacheSize(elem));
-		// make sure size is not a power of two, avoid cache trashing
-		size_t cacheLinesMem = size/cacheSize(elem);
-		if(cacheLinesMem >= L1LINE_N && isPowerOfTwo(cacheLinesMem))
-			size += cacheSize(elem);
-		return size;
-	}
+	static const default_init_t default_init = {};
 
 	/**
 	 * @brief Vectorized array, use this to use Vector Extensions easily	\n
@@ -96,6 +41,7 @@ namespace gm {
 	 * from sizeV()*vecN() (== remStart() == remInd(sizeV())).
 	 * If you must loop from a index that is not multiple of vecN()
 	 * you have to loop through the first indexes until it reaches a multiple of 4.	\n
+	 * Growth sets how the capacity grows and can count reallocations, see Growth.hpp	\n
 	 * Example for a generic loop from start to end:	\n
 	 * ```cpp
 		for (size_t i = min; i < A.beginVI(min); ++i) {
@@ -109,7 +55,7 @@ namespace gm {
 			X[i] += A[i] * B[i];
 		}
 	 * ``` */
-	template <typename T>
+	template <typename T, class Growth = Grow1_5x>
 	class vector {
 
 		public:
@@ -140,15 +86,16 @@ namespace gm {
 			// 23.3.11.2, construct/copy/destroy:
 			vector() noexcept;
 			explicit vector(size_type n);
+			vector(size_type n, default_init_t);
 			vector(size_type n, const T &val);
 			vector(iterator first, iterator last);
 			vector(std::initializer_list<T>);
-			vector(const vector<T> &);
-			vector(vector<T> &&) noexcept;
+			vector(const vector<T, Growth> &);
+			vector(vector<T, Growth> &&) noexcept;
 			~vector() = default;;
-			vector<T> & operator = (const vector<T> &);
-			vector<T> & operator = (vector<T> &&);
-			vector<T> & operator = (std::initializer_list<T>);
+			vector<T, Growth> & operator = (const vector<T, Growth> &);
+			vector<T, Growth> & operator = (vector<T, Growth> &&) noexcept;
+			vector<T, Growth> & operator = (std::initializer_list<T>);
 			void assign(size_type, const T &value);
 			void assign(iterator, iterator);
 			void assign(std::initializer_list<T>);
@@ -170,6 +117,7 @@ namespace gm {
 			size_type capacity() const noexcept;
 			void resize(size_type);
 			void resize(size_type, const T &);
+			void resize_uninitialized(size_type);
 			void reserve(size_type);
 			void shrink_to_fit();
 
@@ -192,24 +140,28 @@ namespace gm {
 			void push_back(const T &);
 			void push_back(T &&);
 			void pop_back();
+			template <class InputIt> void append(InputIt, InputIt);
+			template <class Generator> void append_n(size_type, Generator);
+			template <class ... Args> void emplace_back_unchecked(Args && ... args);
 
 			template <class ... Args> iterator emplace(const_iterator, Args && ...);
 			iterator insert(const_iterator, const T &);
 			iterator insert(const_iterator, T &&);
 			iterator insert(const_iterator, size_type, const T&);
-			template <class InputIt> iterator insert(const_iterator, InputIt, InputIt);
+			template <class InputIt, class = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+			iterator insert(const_iterator, InputIt, InputIt);
 			iterator insert(const_iterator, std::initializer_list<T>);
 			iterator erase(const_iterator);
 			iterator erase(const_iterator, const_iterator);
-			void swap(vector<T> &);
+			void swap(vector<T, Growth> &) noexcept;
 			void clear() noexcept;
 
-			bool operator == (const vector<T> &) const;
-			bool operator != (const vector<T> &) const;
-			bool operator < (const vector<T> &) const;
-			bool operator <= (const vector<T> &) const;
-			bool operator > (const vector<T> &) const;
-			bool operator >= (const vector<T> &) const;
+			bool operator == (const vector<T, Growth> &) const;
+			bool operator != (const vector<T, Growth> &) const;
+			bool operator < (const vector<T, Growth> &) const;
+			bool operator <= (const vector<T, Growth> &) const;
+			bool operator > (const vector<T, Growth> &) const;
+			bool operator >= (const vector<T, Growth> &) const;
 
 			/** @brief n of elems in a Vec<> */
 			size_t vecN() const { return regSize(T); }
@@ -226,12 +178,12 @@ namespace gm {
 
 			// Memory management
 			/** @brief allocates memory for sizeVMem Vec<T>s */
-			T* memAlloc(std::unique_ptr<char[]> & ptr){
+			T* memAlloc(MemPtr & ptr){
 				T* arr;
 				size_t bytes = rsrv_szV()*sizeof(Vec<T>);
 				arr = (T*)al_allloc(bytes, CACHE_LINE_SIZE, ptr);
 
-				assert((arr & (sizeof(Vec<T>) -1)) != 0  && "varray pointer not aligned to sizeof(Vec<elem>) bytes");
+				assert(((uintptr_t)arr & (sizeof(Vec<T>) -1)) == 0  && "vector pointer not aligned to sizeof(Vec<T>) bytes");
 				return arr;
 			}
 			/** @brief allocates memory for sizeVMem Vec<T>s */
@@ -248,76 +200,94 @@ namespace gm {
 
 		protected:
 
-			size_type rsrv_sz_ = STARTING_SIZE;
+			size_type rsrv_sz_ = 0;
 			size_type size_ = 0;
-			T *arr_;
-			std::unique_ptr<char[]> ptr_; //!< only to store the pointer, no access
+			T *arr_ = nullptr;
+			MemPtr ptr_; //!< only to store the pointer, no access
 
 			// Constants
 
 			static const size_type STARTING_SIZE = 4;
-			static const size_type GROWTH_FACTOR = 2;
 			static const size_type MAX_SZ = 1000000000;
 
 			// Memory manipulation
 
-			/** @brief Uses GROWTH_FACTOR to multiply current rsrv_sz_ */
+			/** @brief Makes room for one more elem, see growTo() */
 			void grow();
+			/** @brief Sets rsrv_sz_ to Growth::next(), at least needed and STARTING_SIZE */
+			void growTo(size_type needed) {
+				rsrv_sz_ = Growth::next(rsrv_sz_, needed > STARTING_SIZE ? needed : STARTING_SIZE, sizeof(T));
+			}
 			/** @brief Reallocates data into an array of size rsrv_sz_ */
 			inline void reallocate();
+			/** @brief Makes room for cnt more elems, one reallocation at most */
+			void reserveMore(size_type cnt) {
+				if (size_ + cnt > rsrv_sz_) {
+					growTo(size_ + cnt);
+					reallocate();
+				}
+			}
+			template <class InputIt> void appendRange(InputIt, InputIt, std::input_iterator_tag);
+			template <class ForwardIt> void appendRange(ForwardIt, ForwardIt, std::forward_iterator_tag);
+			template <class ForwardIt> void appendCopy(ForwardIt, size_type, std::false_type);
+			void appendCopy(const T *, size_type, std::true_type);
 	};
 
 
 
-	template <typename T>
-	vector<T>::vector() noexcept {
-		memAlloc();
+	template <typename T, class Growth>
+	vector<T, Growth>::vector() noexcept {
+		// no memory until the first elem, empty vectors cost only the object
 	}
 
-	template <typename T>
-	vector<T>::vector(typename vector<T>::size_type n) {
+	template <typename T, class Growth>
+	vector<T, Growth>::vector(typename vector<T, Growth>::size_type n) {
 		size_type i;
 		rsrv_sz_ = n;
-		grow();
 		memAlloc();
 		for (i = 0; i < n; ++i)
 			arr_[i] = T();
 		size_ = n;
 	}
 
-	template <typename T>
-	vector<T>::vector(typename vector<T>::size_type n, const T &value) {
+	template <typename T, class Growth>
+	vector<T, Growth>::vector(typename vector<T, Growth>::size_type n, default_init_t) {
+		rsrv_sz_ = n;
+		memAlloc();
+		size_ = 0;
+		resize_uninitialized(n);
+	}
+
+	template <typename T, class Growth>
+	vector<T, Growth>::vector(typename vector<T, Growth>::size_type n, const T &value) {
 		size_type i;
 		rsrv_sz_ = n;
-		grow();
 		memAlloc();
 		for (i = 0; i < n; ++i)
 			arr_[i] = value;
 		size_ = n;
 	}
 
-	template <typename T>
-	vector<T>::vector(typename vector<T>::iterator first, typename vector<T>::iterator last) {
+	template <typename T, class Growth>
+	vector<T, Growth>::vector(typename vector<T, Growth>::iterator first, typename vector<T, Growth>::iterator last) {
 		size_type i, count = last - first;
 		rsrv_sz_ = count;
-		grow();
 		memAlloc();
 		for (i = 0; i < count; ++i, ++first)
 			arr_[i] = *first;
 		size_ = count;
 	}
 
-	template <typename T>
-	vector<T>::vector(std::initializer_list<T> lst) {
+	template <typename T, class Growth>
+	vector<T, Growth>::vector(std::initializer_list<T> lst) {
 		rsrv_sz_ = lst.size();
-		grow();
 		memAlloc();
 		for (auto &item: lst)
 			arr_[size_++] = item;
 	}
 
-	template <typename T>
-	vector<T>::vector(const vector<T> &other) {
+	template <typename T, class Growth>
+	vector<T, Growth>::vector(const vector<T, Growth> &other) {
 		size_type i;
 		rsrv_sz_ = other.rsrv_sz_;
 		memAlloc();
@@ -326,60 +296,56 @@ namespace gm {
 		size_ = other.size_;
 	}
 
-	template <typename T>
-	vector<T>::vector(vector<T> &&other) noexcept {
-		size_type i;
-		rsrv_sz_ = other.rsrv_sz_;
-		memAlloc();
-		for (i = 0; i < other.size_; ++i)
-			arr_[i] = std::move(other.arr_[i]);
-		size_ = other.size_;
+	template <typename T, class Growth>
+	vector<T, Growth>::vector(vector<T, Growth> &&other) noexcept
+		: rsrv_sz_(other.rsrv_sz_)
+		, size_(other.size_)
+		, arr_(other.arr_)
+		, ptr_(std::move(other.ptr_))
+	{
+		// steals the buffer, other is left empty without memory
+		other.rsrv_sz_ = 0;
+		other.size_ = 0;
+		other.arr_ = nullptr;
 	}
 
-	template <typename T>
-	vector<T> & vector<T>::operator = (const vector<T> &other) {
+	template <typename T, class Growth>
+	vector<T, Growth> & vector<T, Growth>::operator = (const vector<T, Growth> &other) {
 		size_type i;
 		if (rsrv_sz_ < other.size_) {
-			rsrv_sz_ = other.size_;
-			grow();
+			growTo(other.size_);
 			reallocate();
 		}
 		for (i = 0; i < other.size_; ++i)
 			arr_[i] = other.arr_[i];
 		size_ = other.size_;
+		return *this;
 	}
 
-	template <typename T>
-	vector<T> & vector<T>::operator = (vector<T> &&other) {
-		size_type i;
-		if (rsrv_sz_ < other.size_) {
-			rsrv_sz_ = other.size_;
-			grow();
-			reallocate();
-		}
-		for (i = 0; i < other.size_; ++i)
-			arr_[i] = std::move(other.arr_[i]);
-		size_ = other.size_;
+	template <typename T, class Growth>
+	vector<T, Growth> & vector<T, Growth>::operator = (vector<T, Growth> &&other) noexcept {
+		vector<T, Growth> tmp(std::move(other));
+		swap(tmp);
+		return *this;
 	}
 
-	template <typename T>
-	vector<T> & vector<T>::operator = (std::initializer_list<T> lst) {
+	template <typename T, class Growth>
+	vector<T, Growth> & vector<T, Growth>::operator = (std::initializer_list<T> lst) {
 		if (rsrv_sz_ < lst.size()) {
-			rsrv_sz_ = lst.size();
-			grow();
+			growTo(lst.size());
 			reallocate();
 		}
 		size_ = 0;
 		for (auto &item: lst)
 			arr_[size_++] = item;
+		return *this;
 	}
 
-	template <typename T>
-	void vector<T>::assign(typename vector<T>::size_type count, const T &value) {
+	template <typename T, class Growth>
+	void vector<T, Growth>::assign(typename vector<T, Growth>::size_type count, const T &value) {
 		size_type i;
 		if (count > rsrv_sz_) {
-			rsrv_sz_ = count;
-			grow();
+			growTo(count);
 			reallocate();
 		}
 		for (i = 0; i < count; ++i)
@@ -387,12 +353,11 @@ namespace gm {
 		size_ = count;
 	}
 
-	template <typename T>
-	void vector<T>::assign(typename vector<T>::iterator first, typename vector<T>::iterator last) {
+	template <typename T, class Growth>
+	void vector<T, Growth>::assign(typename vector<T, Growth>::iterator first, typename vector<T, Growth>::iterator last) {
 		size_type i, count = last - first;
 		if (count > rsrv_sz_) {
-			rsrv_sz_ = count;
-			grow();
+			growTo(count);
 			reallocate();
 		}
 		for (i = 0; i < count; ++i, ++first)
@@ -400,12 +365,11 @@ namespace gm {
 		size_ = count;
 	}
 
-	template <typename T>
-	void vector<T>::assign(std::initializer_list<T> lst) {
+	template <typename T, class Growth>
+	void vector<T, Growth>::assign(std::initializer_list<T> lst) {
 		size_type i, count = lst.size();
 		if (count > rsrv_sz_) {
-			rsrv_sz_ = count;
-			grow();
+			growTo(count);
 			reallocate();
 		}
 		i = 0;
@@ -414,187 +378,214 @@ namespace gm {
 	}
 
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::begin() noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::begin() noexcept {
 		return arr_;
 	}
 
-	template <typename T>
-	typename vector<T>::const_iterator vector<T>::cbegin() const noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_iterator vector<T, Growth>::cbegin() const noexcept {
 		return arr_;
 	}
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::end() noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::end() noexcept {
 		return arr_ + size_;
 	}
 
-	template <typename T>
-	typename vector<T>::const_iterator vector<T>::cend() const noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_iterator vector<T, Growth>::cend() const noexcept {
 		return arr_ + size_;
 	}
 
-	template <typename T>
-	typename vector<T>::reverse_iterator vector<T>::rbegin() noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::reverse_iterator vector<T, Growth>::rbegin() noexcept {
 		return reverse_iterator(arr_ + size_);
 	}
 
-	template <typename T>
-	typename vector<T>::const_reverse_iterator vector<T>::crbegin() const noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_reverse_iterator vector<T, Growth>::crbegin() const noexcept {
 		return reverse_iterator(arr_ + size_);
 	}
 
-	template <typename T>
-	typename vector<T>::reverse_iterator vector<T>::rend() noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::reverse_iterator vector<T, Growth>::rend() noexcept {
 		return reverse_iterator(arr_);
 	}
 
-	template <typename T>
-	typename vector<T>::const_reverse_iterator vector<T>::crend() const noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_reverse_iterator vector<T, Growth>::crend() const noexcept {
 		return reverse_iterator(arr_);
 	}
 
 
-	template <typename T>
-	inline void vector<T>::reallocate() {
-		std::unique_ptr<char[]> tptr_;
+	template <typename T, class Growth>
+	inline void vector<T, Growth>::reallocate() {
+		// mapped buffers are resized by the kernel moving the pages, no copy
+		if (std::is_trivially_copyable<T>::value && ptr_ && ptr_.get_deleter().mapped) {
+			if (T* tarr_ = (T*)al_remap(rsrv_szV()*sizeof(Vec<T>), ptr_)) {
+				arr_ = tarr_;
+				Growth::onRealloc(size_, rsrv_sz_, sizeof(T), true);
+				return;
+			}
+		}
+		MemPtr tptr_;
 		T* tarr_ = memAlloc(tptr_);
-		memcpy(tarr_, arr_, size_ * sizeof(T));
+		if (size_)
+			memcpy(tarr_, arr_, size_ * sizeof(T));
 
 		ptr_.swap(tptr_);
 		arr_ = tarr_;
+		Growth::onRealloc(size_, rsrv_sz_, sizeof(T), false);
 	}
 
 
-	template <typename T>
-	bool vector<T>::empty() const noexcept {
+	template <typename T, class Growth>
+	bool vector<T, Growth>::empty() const noexcept {
 		return size_ == 0;
 	}
 
-	template <typename T>
-	typename vector<T>::size_type vector<T>::size() const noexcept{
+	template <typename T, class Growth>
+	typename vector<T, Growth>::size_type vector<T, Growth>::size() const noexcept{
 		return size_;
 	}
 
-	template <typename T>
-	typename vector<T>::size_type vector<T>::max_size() const noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::size_type vector<T, Growth>::max_size() const noexcept {
 		return MAX_SZ;
 	}
 
-	template <typename T>
-	typename vector<T>::size_type vector<T>::capacity() const noexcept {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::size_type vector<T, Growth>::capacity() const noexcept {
 		return rsrv_sz_;
 	}
 
-	template <typename T>
-	void vector<T>::resize(typename vector<T>::size_type sz) {
+	template <typename T, class Growth>
+	void vector<T, Growth>::resize(typename vector<T, Growth>::size_type sz) {
 		if (sz > size_) {
 			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
+				growTo(sz);
 				reallocate();
 			}
-		} else {
-			size_type i;
-			for (i = size_; i < sz; ++i)
+		} else if (!std::is_trivially_destructible<T>::value) {
+			for (size_type i = sz; i < size_; ++i)
 				arr_[i].~T();
 		}
 		size_ = sz;
 	}
 
-	template <typename T>
-	void vector<T>::resize(typename vector<T>::size_type sz, const T &c) {
+	template <typename T, class Growth>
+	void vector<T, Growth>::resize(typename vector<T, Growth>::size_type sz, const T &c) {
 		if (sz > size_) {
 			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
+				growTo(sz);
 				reallocate();
 			}
 			size_type i;
 			for (i = size_; i < sz; ++i)
 				arr_[i] = c;
-		} else {
-			size_type i;
-			for (i = size_; i < sz; ++i)
+		} else if (!std::is_trivially_destructible<T>::value) {
+			for (size_type i = sz; i < size_; ++i)
 				arr_[i].~T();
 		}
 		size_ = sz;
 	}
 
-	template <typename T>
-	void vector<T>::reserve(typename vector<T>::size_type _sz) {
+	/**
+	 * @brief resize() without filling: trivially constructible new elems are
+	 * left as they are in memory, others are default initialized	\n
+	 * Fresh big buffers are mapped memory (see al_allloc), their pages
+	 * are only faulted in when first written
+	 */
+	template <typename T, class Growth>
+	void vector<T, Growth>::resize_uninitialized(typename vector<T, Growth>::size_type sz) {
+		if (sz > rsrv_sz_) {
+			growTo(sz);
+			reallocate();
+		}
+		if (!std::is_trivially_default_constructible<T>::value) {
+			for (size_type i = size_; i < sz; ++i)
+				new (&arr_[i]) T;
+		}
+		size_ = sz;
+	}
+
+	template <typename T, class Growth>
+	void vector<T, Growth>::reserve(typename vector<T, Growth>::size_type _sz) {
 		if (_sz > rsrv_sz_) {
 			rsrv_sz_ = _sz;
 			reallocate();
 		}
 	}
 
-	template <typename T>
-	void vector<T>::shrink_to_fit() {
+	template <typename T, class Growth>
+	void vector<T, Growth>::shrink_to_fit() {
 		rsrv_sz_ = size_;
 		reallocate();
 	}
 
 
-	template <typename T>
-	typename vector<T>::reference vector<T>::operator [](typename vector<T>::size_type idx) {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::reference vector<T, Growth>::operator [](typename vector<T, Growth>::size_type idx) {
 		return arr_[idx];
 	}
 
-	template <typename T>
-	typename vector<T>::const_reference vector<T>::operator [](typename vector<T>::size_type idx) const {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_reference vector<T, Growth>::operator [](typename vector<T, Growth>::size_type idx) const {
 		return arr_[idx];
 	}
 
-	template <typename T>
-	typename vector<T>::reference vector<T>::at(size_type pos) {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::reference vector<T, Growth>::at(size_type pos) {
 		if (pos < size_)
 			return arr_[pos];
 		else
 			throw std::out_of_range("accessed position is out of range");
 	}
 
-	template <typename T>
-	typename vector<T>::const_reference vector<T>::at(size_type pos) const {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_reference vector<T, Growth>::at(size_type pos) const {
 		if (pos < size_)
 			return arr_[pos];
 		else
 			throw std::out_of_range("accessed position is out of range");
 	}
 
-	template <typename T>
-	typename vector<T>::reference vector<T>::front() {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::reference vector<T, Growth>::front() {
 		return arr_[0];
 	}
 
-	template <typename T>
-	typename vector<T>::const_reference vector<T>::front() const {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_reference vector<T, Growth>::front() const {
 		return arr_[0];
 	}
 
-	template <typename T>
-	typename vector<T>::reference vector<T>::back() {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::reference vector<T, Growth>::back() {
 		return arr_[size_ - 1];
 	}
 
-	template <typename T>
-	typename vector<T>::const_reference vector<T>::back() const {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::const_reference vector<T, Growth>::back() const {
 		return arr_[size_ - 1];
 	}
 
 
-	template <typename T>
-	T * vector<T>::data() noexcept {
+	template <typename T, class Growth>
+	T * vector<T, Growth>::data() noexcept {
 		return arr_;
 	}
 
-	template <typename T>
-	const T * vector<T>::data() const noexcept {
+	template <typename T, class Growth>
+	const T * vector<T, Growth>::data() const noexcept {
 		return arr_;
 	}
 
 
-	template <typename T>
+	template <typename T, class Growth>
 	template <class ... Args>
-	void vector<T>::emplace_back(Args && ... args) {
+	void vector<T, Growth>::emplace_back(Args && ... args) {
 		if (size_ == rsrv_sz_) {
 			grow();
 			reallocate();
@@ -603,8 +594,8 @@ namespace gm {
 		++size_;
 	}
 
-	template <typename T>
-	void vector<T>::push_back(const T &val) {
+	template <typename T, class Growth>
+	void vector<T, Growth>::push_back(const T &val) {
 		if (size_ == rsrv_sz_) {
 			grow();
 			reallocate();
@@ -613,13 +604,13 @@ namespace gm {
 		++size_;
 	}
 
-	template <typename T>
-	void vector<T>::grow() {
-		rsrv_sz_ <<= GROWTH_FACTOR;
+	template <typename T, class Growth>
+	void vector<T, Growth>::grow() {
+		growTo(size_ + 1);
 	}
 
-	template <typename T>
-	void vector<T>::push_back(T &&val) {
+	template <typename T, class Growth>
+	void vector<T, Growth>::push_back(T &&val) {
 		if (size_ == rsrv_sz_) {
 			grow();
 			reallocate();
@@ -628,98 +619,195 @@ namespace gm {
 		++size_;
 	}
 
-	template <typename T>
-	void vector<T>::pop_back() {
+	template <typename T, class Growth>
+	void vector<T, Growth>::pop_back() {
 		--size_;
-		arr_[size_].~T();
+		if (!std::is_trivially_destructible<T>::value)
+			arr_[size_].~T();
+	}
+
+	namespace detail {
+		/** @brief true if It points to elems memcpy'able into T elems */
+		template <typename T, class It>
+		using isMemcpyIter = std::integral_constant<bool, std::is_pointer<It>::value
+			&& std::is_same<typename std::remove_cv<typename std::remove_pointer<It>::type>::type, T>::value
+			&& std::is_trivially_copyable<T>::value>;
+	}
+
+	/**
+	 * @brief Appends [first, last), reallocating at most once for forward iterators	\n
+	 * Pointers to trivially copyable T are copied with memcpy, and may
+	 * point into this vector. Input iterators (streams) are push_back()'ed.
+	 * ```cpp
+		gm::vector<float> v;
+		v.append(batch, batch + n);
+		v.append(std::istream_iterator<float>(in), std::istream_iterator<float>());
+	 * ```
+	 */
+	template <typename T, class Growth>
+	template <class InputIt>
+	void vector<T, Growth>::append(InputIt first, InputIt last) {
+		appendRange(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+	}
+
+	template <typename T, class Growth>
+	template <class InputIt>
+	void vector<T, Growth>::appendRange(InputIt first, InputIt last, std::input_iterator_tag) {
+		for ( ; first != last; ++first)
+			push_back(*first);
+	}
+
+	template <typename T, class Growth>
+	template <class ForwardIt>
+	void vector<T, Growth>::appendRange(ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+		appendCopy(first, std::distance(first, last), detail::isMemcpyIter<T, ForwardIt>());
+	}
+
+	template <typename T, class Growth>
+	template <class ForwardIt>
+	void vector<T, Growth>::appendCopy(ForwardIt first, typename vector<T, Growth>::size_type cnt, std::false_type) {
+		reserveMore(cnt);
+		T *dst = arr_ + size_;
+		for (size_type i = 0; i < cnt; ++i, ++first)
+			dst[i] = *first;
+		size_ += cnt;
+	}
+
+	template <typename T, class Growth>
+	void vector<T, Growth>::appendCopy(const T *first, typename vector<T, Growth>::size_type cnt, std::true_type) {
+		if (!cnt) return;
+		// a range of this vector moves with the reallocation
+		bool self = arr_ && first >= arr_ && first < arr_ + size_;
+		size_type off = self ? first - arr_ : 0;
+		reserveMore(cnt);
+		if (self)
+			first = arr_ + off;
+		memcpy(arr_ + size_, first, cnt * sizeof(T));
+		size_ += cnt;
+	}
+
+	/**
+	 * @brief Appends n elems returned by gen(), reallocating at most once
+	 * ```cpp
+		v.append_n(n, [&]{ return read<int>(in); });
+	 * ```
+	 */
+	template <typename T, class Growth>
+	template <class Generator>
+	void vector<T, Growth>::append_n(typename vector<T, Growth>::size_type n, Generator gen) {
+		reserveMore(n);
+		T *dst = arr_ + size_;
+		for (size_type i = 0; i < n; ++i)
+			dst[i] = gen();
+		size_ += n;
+	}
+
+	/**
+	 * @brief emplace_back() without the capacity check, size() < capacity()
+	 * must hold, reserve() up front
+	 * ```cpp
+		v.reserve(v.size() + n);
+		for (size_t i = 0; i < n; ++i)
+			v.emplace_back_unchecked(x[i], y[i]);
+	 * ```
+	 */
+	template <typename T, class Growth>
+	template <class ... Args>
+	void vector<T, Growth>::emplace_back_unchecked(Args && ... args) {
+		assert(size_ < rsrv_sz_ && "emplace_back_unchecked() past capacity()");
+		arr_[size_] = T( std::forward<Args>(args) ... );
+		++size_;
 	}
 
 
-	template <typename T>
+	template <typename T, class Growth>
 	template <class ... Args>
-	typename vector<T>::iterator vector<T>::emplace(typename vector<T>::const_iterator it, Args && ... args) {
-		iterator iit = &arr_[it - arr_];
+	typename vector<T, Growth>::iterator vector<T, Growth>::emplace(typename vector<T, Growth>::const_iterator it, Args && ... args) {
+		size_type pos = it - arr_;
 		if (size_ == rsrv_sz_) {
 			grow();
 			reallocate();
 		}
-		memmove(iit + 1, iit, (size_ - (it - arr_)) * sizeof(T));
+		iterator iit = arr_ + pos;
+		memmove(iit + 1, iit, (size_ - pos) * sizeof(T));
 		(*iit) = std::move( T( std::forward<Args>(args) ... ) );
 		++size_;
 		return iit;
 	}
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator it, const T &val) {
-		iterator iit = &arr_[it - arr_];
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::insert(typename vector<T, Growth>::const_iterator it, const T &val) {
+		size_type pos = it - arr_;
 		if (size_ == rsrv_sz_) {
 			grow();
 			reallocate();
 		}
-		memmove(iit + 1, iit, (size_ - (it - arr_)) * sizeof(T));
+		iterator iit = arr_ + pos;
+		memmove(iit + 1, iit, (size_ - pos) * sizeof(T));
 		(*iit) = val;
 		++size_;
 		return iit;
 	}
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator it, T &&val) {
-		iterator iit = &arr_[it - arr_];
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::insert(typename vector<T, Growth>::const_iterator it, T &&val) {
+		size_type pos = it - arr_;
 		if (size_ == rsrv_sz_) {
 			grow();
 			reallocate();
 		}
-		memmove(iit + 1, iit, (size_ - (it - arr_)) * sizeof(T));
+		iterator iit = arr_ + pos;
+		memmove(iit + 1, iit, (size_ - pos) * sizeof(T));
 		(*iit) = std::move(val);
 		++size_;
 		return iit;
 	}
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator it, typename vector<T>::size_type cnt, const T &val) {
-		iterator f = &arr_[it - arr_];
-		if (!cnt) return f;
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::insert(typename vector<T, Growth>::const_iterator it, typename vector<T, Growth>::size_type cnt, const T &val) {
+		size_type pos = it - arr_;
+		if (!cnt) return arr_ + pos;
 		if (size_ + cnt > rsrv_sz_) {
-			rsrv_sz_ = (size_ + cnt);
-			grow();
+			growTo(size_ + cnt);
 			reallocate();
 		}
-		memmove(f + cnt, f, (size_ - (it - arr_)) * sizeof(T));
+		iterator f = arr_ + pos;
+		memmove(f + cnt, f, (size_ - pos) * sizeof(T));
 		size_ += cnt;
 		for (iterator it = f; cnt--; ++it)
 			(*it) = val;
 		return f;
 	}
 
-	template <typename T>
-	template <class InputIt>
-	typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator it, InputIt first, InputIt last) {
-		iterator f = &arr_[it - arr_];
+	template <typename T, class Growth>
+	template <class InputIt, class>
+	typename vector<T, Growth>::iterator vector<T, Growth>::insert(typename vector<T, Growth>::const_iterator it, InputIt first, InputIt last) {
+		size_type pos = it - arr_;
 		size_type cnt = last - first;
-		if (!cnt) return f;
+		if (!cnt) return arr_ + pos;
 		if (size_ + cnt > rsrv_sz_) {
-			rsrv_sz_ = (size_ + cnt);
-			grow();
+			growTo(size_ + cnt);
 			reallocate();
 		}
-		memmove(f + cnt, f, (size_ - (it - arr_)) * sizeof(T));
+		iterator f = arr_ + pos;
+		memmove(f + cnt, f, (size_ - pos) * sizeof(T));
 		for (iterator it = f; first != last; ++it, ++first)
 			(*it) = *first;
 		size_ += cnt;
 		return f;
 	}
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator it, std::initializer_list<T> lst) {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::insert(typename vector<T, Growth>::const_iterator it, std::initializer_list<T> lst) {
 		size_type cnt = lst.size();
-		iterator f = &arr_[it - arr_];
-		if (!cnt) return f;
+		size_type pos = it - arr_;
+		if (!cnt) return arr_ + pos;
 		if (size_ + cnt > rsrv_sz_) {
-			rsrv_sz_ = (size_ + cnt);
-			grow();
+			growTo(size_ + cnt);
 			reallocate();
 		}
-		memmove(f + cnt, f, (size_ - (it - arr_)) * sizeof(T));
+		iterator f = arr_ + pos;
+		memmove(f + cnt, f, (size_ - pos) * sizeof(T));
 		iterator iit = f;
 		for (auto &item: lst) {
 			(*iit) = item;
@@ -729,791 +817,202 @@ namespace gm {
 		return f;
 	}
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::erase(typename vector<T>::const_iterator it) {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::erase(typename vector<T, Growth>::const_iterator it) {
 		iterator iit = &arr_[it - arr_];
-		(*iit).~T();
+		if (!std::is_trivially_destructible<T>::value)
+			(*iit).~T();
 		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(T));
 		--size_;
 		return iit;
 	}
 
-	template <typename T>
-	typename vector<T>::iterator vector<T>::erase(typename vector<T>::const_iterator first, typename vector<T>::const_iterator last) {
+	template <typename T, class Growth>
+	typename vector<T, Growth>::iterator vector<T, Growth>::erase(typename vector<T, Growth>::const_iterator first, typename vector<T, Growth>::const_iterator last) {
 		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		for ( ; first != last; ++first)
-			(*first).~T();
+		size_type cnt = last - first;
+		if (!cnt) return f;
+		if (!std::is_trivially_destructible<T>::value) {
+			for ( ; first != last; ++first)
+				(*first).~T();
+		}
 		memmove(f, last, (size_ - (last - arr_)) * sizeof(T));
-		size_ -= last - first;
+		size_ -= cnt;
 		return f;
 	}
 
-	template <typename T>
-	void vector<T>::swap(vector<T> &rhs) {
-		size_t tsize_ = size_,
-			   trsrv_sz_ = rsrv_sz_;
-		T *tarr_ = arr_;
-
-		size_ = rhs.size_;
-		rsrv_sz_ = rhs.rsrv_sz_;
-		arr_ = rhs.arr_;
-
-		rhs.size_ = tsize_;
-		rhs.rsrv_sz_ = trsrv_sz_;
-		rhs.arr_ = tarr_;
+	template <typename T, class Growth>
+	void vector<T, Growth>::swap(vector<T, Growth> &rhs) noexcept {
+		std::swap(size_, rhs.size_);
+		std::swap(rsrv_sz_, rhs.rsrv_sz_);
+		std::swap(arr_, rhs.arr_);
+		ptr_.swap(rhs.ptr_);
 	}
 
-	template <typename T>
-	void vector<T>::clear() noexcept {
-		size_type i;
-		for (i = 0; i < size_; ++i)
-			arr_[i].~T();
+	template <typename T, class Growth>
+	void vector<T, Growth>::clear() noexcept {
+		if (!std::is_trivially_destructible<T>::value) {
+			for (size_type i = 0; i < size_; ++i)
+				arr_[i].~T();
+		}
 		size_ = 0;
 	}
 
 
-	template <typename T>
-	bool vector<T>::operator == (const vector<T> &rhs) const {
-		if (size_ != rhs.size_) return false;
-		size_type i;
-		for (i = 0; i < size_; ++i)
-			if (arr_[i] != rhs.arr_[i])
-				return false;
-		return true;
-	}
-
-	template <typename T>
-	bool vector<T>::operator != (const vector<T> &rhs) const {
-		if (size_ != rhs.size_) return true;
-		size_type i;
-		for (i = 0; i < size_; ++i)
-			if (arr_[i] != rhs.arr_[i])
-				return true;
-		return false;
-	}
-
-	template <typename T>
-	bool vector<T>::operator < (const vector<T> &rhs) const {
-		size_type i, j, ub = size_ < rhs.size_ ? size_ : rhs.size_;
-		for (i = 0; i < ub; ++i)
-			if (arr_[i] != rhs.arr_[i])
-				return arr_[i] < rhs.arr_[i];
-		return size_ < rhs.size_;
-	}
-
-	template <typename T>
-	bool vector<T>::operator <= (const vector<T> &rhs) const {
-		size_type i, j, ub = size_ < rhs.size_ ? size_ : rhs.size_;
-		for (i = 0; i < ub; ++i)
-			if (arr_[i] != rhs.arr_[i])
-				return arr_[i] < rhs.arr_[i];
-		return size_ <= rhs.size_;
-	}
-
-	template <typename T>
-	bool vector<T>::operator > (const vector<T> &rhs) const {
-		size_type i, j, ub = size_ < rhs.size_ ? size_ : rhs.size_;
-		for (i = 0; i < ub; ++i)
-			if (arr_[i] != rhs.arr_[i])
-				return arr_[i] > rhs.arr_[i];
-		return size_ > rhs.size_;
-	}
-
-	template <typename T>
-	bool vector<T>::operator >= (const vector<T> &rhs) const {
-		size_type i, j, ub = size_ < rhs.size_ ? size_ : rhs.size_;
-		for (i = 0; i < ub; ++i)
-			if (arr_[i] != rhs.arr_[i])
-				return arr_[i] > rhs.arr_[i];
-		return size_ >= rhs.size_;
-	}
-
-	template <>
-	void vector<signed char>::resize(typename vector<signed char>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+	namespace detail {
+		/** @brief first index where x and y differ, n if none, vectorized for isSimdElem<T> */
+		template <typename T>
+		size_t vMismatch(const T *x, const T *y, size_t n, std::true_type) {
+			return gm::mismatch(x, y, n);
 		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<unsigned char>::resize(typename vector<unsigned char>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+		template <typename T>
+		size_t vMismatch(const T *x, const T *y, size_t n, std::false_type) {
+			size_t i;
+			for (i = 0; i < n; ++i)
+				if (x[i] != y[i])
+					break;
+			return i;
 		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<char>::resize(typename vector<char>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+		template <typename T>
+		size_t vMismatch(const T *x, const T *y, size_t n) {
+			return vMismatch(x, y, n, isSimdElem<T>());
 		}
-		size_ = sz;
-	}
 
-	template <>
-	void vector<short int>::resize(typename vector<short int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+		/** @brief first index of value in x, n if none, vectorized for isSimdElem<T> */
+		template <typename T>
+		size_t vFind(const T *x, size_t n, const T &value, std::true_type) {
+			return gm::find(x, n, value);
 		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<unsigned short int>::resize(typename vector<unsigned short int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+		template <typename T>
+		size_t vFind(const T *x, size_t n, const T &value, std::false_type) {
+			size_t i;
+			for (i = 0; i < n; ++i)
+				if (x[i] == value)
+					break;
+			return i;
 		}
-		size_ = sz;
-	}
 
-	template <>
-	void vector<int>::resize(typename vector<int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+		/** @brief n of value in x, vectorized for isSimdElem<T> */
+		template <typename T>
+		size_t vCount(const T *x, size_t n, const T &value, std::true_type) {
+			return gm::count(x, n, value);
 		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<unsigned int>::resize(typename vector<unsigned int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+		template <typename T>
+		size_t vCount(const T *x, size_t n, const T &value, std::false_type) {
+			size_t c = 0;
+			for (size_t i = 0; i < n; ++i)
+				c += x[i] == value;
+			return c;
 		}
-		size_ = sz;
-	}
 
-	template <>
-	void vector<long int>::resize(typename vector<long int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
+		/** @brief -1, 0 or 1 as x is lexicographically less, equal or greater than y */
+		template <typename T>
+		int vCompare(const T *x, size_t nx, const T *y, size_t ny) {
+			size_t ub = nx < ny ? nx : ny;
+			size_t i = vMismatch(x, y, ub);
+			if (i < ub)
+				return x[i] < y[i] ? -1 : 1;
+			return nx < ny ? -1 : nx > ny ? 1 : 0;
 		}
-		size_ = sz;
 	}
 
-	template <>
-	void vector<unsigned long int>::resize(typename vector<unsigned long int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
-		}
-		size_ = sz;
+	template <typename T, class Growth>
+	bool vector<T, Growth>::operator == (const vector<T, Growth> &rhs) const {
+		if (size_ != rhs.size_) return false;
+		return detail::vMismatch(arr_, rhs.arr_, size_) == size_;
 	}
 
-	template <>
-	void vector<long long int>::resize(typename vector<long long int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
-		}
-		size_ = sz;
+	template <typename T, class Growth>
+	bool vector<T, Growth>::operator != (const vector<T, Growth> &rhs) const {
+		return !(*this == rhs);
 	}
 
-	template <>
-	void vector<unsigned long long int>::resize(typename vector<unsigned long long int>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
-		}
-		size_ = sz;
+	template <typename T, class Growth>
+	bool vector<T, Growth>::operator < (const vector<T, Growth> &rhs) const {
+		return detail::vCompare(arr_, size_, rhs.arr_, rhs.size_) < 0;
 	}
 
-	template <>
-	void vector<float>::resize(typename vector<float>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
-		}
-		size_ = sz;
+	template <typename T, class Growth>
+	bool vector<T, Growth>::operator <= (const vector<T, Growth> &rhs) const {
+		return detail::vCompare(arr_, size_, rhs.arr_, rhs.size_) <= 0;
 	}
 
-	template <>
-	void vector<double>::resize(typename vector<double>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
-		}
-		size_ = sz;
+	template <typename T, class Growth>
+	bool vector<T, Growth>::operator > (const vector<T, Growth> &rhs) const {
+		return detail::vCompare(arr_, size_, rhs.arr_, rhs.size_) > 0;
 	}
 
-	template <>
-	void vector<long double>::resize(typename vector<long double>::size_type sz) {
-		if (sz > rsrv_sz_) {
-			rsrv_sz_ = sz;
-			reallocate();
-		}
-		size_ = sz;
+	template <typename T, class Growth>
+	bool vector<T, Growth>::operator >= (const vector<T, Growth> &rhs) const {
+		return detail::vCompare(arr_, size_, rhs.arr_, rhs.size_) >= 0;
 	}
 
-
-	template <>
-	void vector<signed char>::resize(typename vector<signed char>::size_type sz, const signed char &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
+	/** @brief index of the first elem equal to value, size() if none,
+	 * vectorized with early exit for arithmetic T */
+	template <typename T, class Growth>
+	size_t find(const vector<T, Growth> &v, const T &value) {
+		return detail::vFind(v.data(), v.size(), value, isSimdElem<T>());
 	}
 
-	template <>
-	void vector<unsigned char>::resize(typename vector<unsigned char>::size_type sz, const unsigned char &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
+	/** @brief n of elems equal to value, vectorized for arithmetic T */
+	template <typename T, class Growth>
+	size_t count(const vector<T, Growth> &v, const T &value) {
+		return detail::vCount(v.data(), v.size(), value, isSimdElem<T>());
 	}
 
-	template <>
-	void vector<char>::resize(typename vector<char>::size_type sz, const char &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
+	/** @brief true if an elem is equal to value, see find() */
+	template <typename T, class Growth>
+	bool contains(const vector<T, Growth> &v, const T &value) {
+		return find(v, value) != v.size();
 	}
 
-	template <>
-	void vector<short int>::resize(typename vector<short int>::size_type sz, const short int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
+	namespace detail {
+		/** @brief compact() for isSimdElem<T> */
+		template <typename T, class Pred>
+		size_t vCompact(T *x, size_t n, Pred &pred, std::true_type) {
+			return gm::compact(x, n, pred);
 		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<unsigned short int>::resize(typename vector<unsigned short int>::size_type sz, const unsigned short int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
+		template <typename T, class Pred>
+		size_t vCompact(T *x, size_t n, Pred &pred, std::false_type) {
+			size_t j = 0;
+			for (size_t i = 0; i < n; ++i) {
+				T val = x[i];
+				x[j] = val;
+				j += !pred(val);
 			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
+			return j;
 		}
-		size_ = sz;
 	}
 
-	template <>
-	void vector<int>::resize(typename vector<int>::size_type sz, const int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
+	/**
+	 * @brief Erases the elems with pred(elem) in a single pass keeping the order
+	 * of the others, O(size()) unlike erase() in a loop, vectorized for arithmetic T
+	 * @return n of elems erased
+	 * ```cpp
+		gm::erase_if(v, [](float x){ return x < 0; });
+	 * ```
+	 */
+	template <typename T, class Growth, class Pred>
+	size_t erase_if(vector<T, Growth> &v, Pred pred) {
+		size_t n = v.size();
+		size_t kept = detail::vCompact(v.data(), n, pred, isSimdElem<T>());
+		v.erase(v.begin() + kept, v.end());
+		assert(v.size() == kept && "erase_if: size not truncated to the kept elems");
+		return n - kept;
 	}
 
-	template <>
-	void vector<unsigned int>::resize(typename vector<unsigned int>::size_type sz, const unsigned int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
+	/** @brief Sorts the elems ascending, see sort(T*, size_t) */
+	template <typename T, class Growth>
+	void sort(vector<T, Growth> &v) {
+		sort(v.data(), v.size(), v.size() ? v.rsrv_szV()*v.vecN() : 0);
 	}
 
-	template <>
-	void vector<long int>::resize(typename vector<long int>::size_type sz, const long int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
+	/** @brief Erases the elems equal to value, see erase_if()
+	 * @return n of elems erased */
+	template <typename T, class Growth>
+	size_t erase(vector<T, Growth> &v, const T &value) {
+		T val = value;
+		return erase_if(v, [val](const T &x) { return x == val; });
 	}
 
-	template <>
-	void vector<unsigned long int>::resize(typename vector<unsigned long int>::size_type sz, const unsigned long int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<long long int>::resize(typename vector<long long int>::size_type sz, const long long int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<unsigned long long int>::resize(typename vector<unsigned long long int>::size_type sz, const unsigned long long int &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<float>::resize(typename vector<float>::size_type sz, const float &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<double>::resize(typename vector<double>::size_type sz, const double &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<long double>::resize(typename vector<long double>::size_type sz, const long double &c) {
-		if (sz > size_) {
-			if (sz > rsrv_sz_) {
-				rsrv_sz_ = sz;
-				reallocate();
-			}
-			size_type i;
-			for (i = size_; i < sz; ++i)
-				arr_[i] = c;
-		}
-		size_ = sz;
-	}
-
-	template <>
-	void vector<signed char>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<unsigned char>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<char>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<short int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<unsigned short int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<unsigned int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<long int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<unsigned long int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<long long int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<unsigned long long int>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<float>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<double>::pop_back() {
-		--size_;
-	}
-
-	template <>
-	void vector<long double>::pop_back() {
-		--size_;
-	}
-
-
-	template <>
-	typename vector<signed char>::iterator vector<signed char>::erase(typename vector<signed char>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(signed char));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<unsigned char>::iterator vector<unsigned char>::erase(typename vector<unsigned char>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(unsigned char));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<char>::iterator vector<char>::erase(typename vector<char>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(char));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<short int>::iterator vector<short int>::erase(typename vector<short int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(short int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<unsigned short int>::iterator vector<unsigned short int>::erase(typename vector<unsigned short int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(unsigned short int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<int>::iterator vector<int>::erase(typename vector<int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<unsigned int>::iterator vector<unsigned int>::erase(typename vector<unsigned int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(unsigned int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<long int>::iterator vector<long int>::erase(typename vector<long int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(long int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<unsigned long int>::iterator vector<unsigned long int>::erase(typename vector<unsigned long int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(unsigned long int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<long long int>::iterator vector<long long int>::erase(typename vector<long long int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(long long int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<unsigned long long int>::iterator vector<unsigned long long int>::erase(typename vector<unsigned long long int>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(unsigned long long int));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<float>::iterator vector<float>::erase(typename vector<float>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(float));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<double>::iterator vector<double>::erase(typename vector<double>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(double));
-		--size_;
-		return iit;
-	}
-
-	template <>
-	typename vector<long double>::iterator vector<long double>::erase(typename vector<long double>::const_iterator it) {
-		iterator iit = &arr_[it - arr_];
-		memmove(iit, iit + 1, (size_ - (it - arr_) - 1) * sizeof(long double));
-		--size_;
-		return iit;
-	}
-
-
-	template <>
-	typename vector<signed char>::iterator vector<signed char>::erase(typename vector<signed char>::const_iterator first, typename vector<signed char>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(signed char));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<unsigned char>::iterator vector<unsigned char>::erase(typename vector<unsigned char>::const_iterator first, typename vector<unsigned char>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(unsigned char));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<char>::iterator vector<char>::erase(typename vector<char>::const_iterator first, typename vector<char>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(char));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<short int>::iterator vector<short int>::erase(typename vector<short int>::const_iterator first, typename vector<short int>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(short int));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<unsigned short int>::iterator vector<unsigned short int>::erase(typename vector<unsigned short int>::const_iterator first, typename vector<unsigned short int>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(unsigned short int));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<int>::iterator vector<int>::erase(typename vector<int>::const_iterator first, typename vector<int>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(int));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<unsigned int>::iterator vector<unsigned int>::erase(typename vector<unsigned int>::const_iterator first, typename vector<unsigned int>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(unsigned int));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<long long int>::iterator vector<long long int>::erase(typename vector<long long int>::const_iterator first, typename vector<long long int>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(long long int));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<unsigned long long int>::iterator vector<unsigned long long int>::erase(typename vector<unsigned long long int>::const_iterator first, typename vector<unsigned long long int>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(unsigned long long int));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<float>::iterator vector<float>::erase(typename vector<float>::const_iterator first, typename vector<float>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(float));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<double>::iterator vector<double>::erase(typename vector<double>::const_iterator first, typename vector<double>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(double));
-		size_ -= last - first;
-		return f;
-	}
-
-	template <>
-	typename vector<long double>::iterator vector<long double>::erase(typename vector<long double>::const_iterator first, typename vector<long double>::const_iterator last) {
-		iterator f = &arr_[first - arr_];
-		if (first == last) return f;
-		memmove(f, last, (size_ - (last - arr_)) * sizeof(long double));
-		size_ -= last - first;
-		return f;
-	}
-
-
-	template <>
-	void vector<signed char>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<unsigned char>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<char>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<short int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<unsigned short int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<unsigned int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<long int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<unsigned long int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<long long int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<unsigned long long int>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<float>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<double>::clear() noexcept {
-		size_ = 0;
-	}
-
-	template <>
-	void vector<long double>::clear() noexcept {
-		size_ = 0;
-	}
-
-
 }
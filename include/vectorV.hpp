@@ -9,82 +9,11 @@
 #include <assert.h>
 #include <exception>
 
-#include "bytes.h"
-
-#define unroll(v,n) for(size_t v = 0; v < n; ++v)
-#define unroll2D(vi,ni, vj,nj) unroll(vi,ni)unroll(vj,nj)
-#define vec(varr, _i_) for(size_t _i_ = 0; _i_ < varr.vecN(); ++_i_)
-
-#define gm_vectorized_loop_(v, min,max, _i_, block, _vi_, blockVec)	\
-{ 	\
-	size_t _endVI;		\
-	size_t _beginVI = v.loop(min, max, _endVI);		\
-	for (size_t _i_ = min; _i_ < _beginVI; ++_i_) block		\
-	for (size_t _vi_ = _beginVI/v.vecN(); _vi_ < _endVI; ++_vi_){		\
-    blockVec		\
-    }for (size_t _i_ = _endVI*v.vecN(); _i_ <= max; ++_i_) block		\
-}
-// Example of usage, where A,B,X are gm::vectorV<>s
-// gm_vectorized_loop_(A, 0,size-1,
-// 	i,  {
-// 		X[i] += A[i] * B[i];
-// 	},
-// 	vi,  {
-// 		X.atV(vi).v += A.atV(vi).v * B.atV(vi).v;
-// 	}
-// )
+#include "Vec.hpp"
 
 namespace gm
 {
 
-/**
- * @class Vec
- * @brief Vectorized type, performs operations in multiple elements at once
- * using Vector Extensions from gcc, see the compiler doc
- *
- * ```cpp
-	Vec<double> a,b,c;
-	c += a * b; // 4 doubles will be multiplied in one instruction
-	// can be individualy be accessed like Vec<> is an array
-	for(int i = 0; i < VecN(double); ++i)
-		std::cout << c[i] << " ";
-	std::cout << std::endl;
- * ```
- * the number of elems in the Vec is regSize(elem) */
-template <typename T>
-using Vec __attribute__ ((vector_size (REG_SZ))) = T;
-
-/**
- * @brief Allocates size*sizeof(elem) and aligns it into a boundary-bit boundary
- * @param ppElement pointer to array (pointer)
- * @param size number of elems in your resulting pointer
- * @param boundary : Power of two, else the behavior is undefined
- * @return The pointer you should free, don't lose it
- */
-void* al_allloc(size_t size, size_t boundary, std::unique_ptr<char[]> & pMem){
-	size_t bytes = size + boundary-1;
-	// pMem = std::move(std::make_unique<char[]>(bytes)); // Very slow
-	pMem.reset(new char[bytes]);
-
-	auto tmpPtr = (void*)pMem.get();
-	return std::align(boundary, size, tmpPtr, bytes);
-}
-/**
- * @brief Calculated padded size
- * to align the end to a cache line and avoid cache trashing
- * will be a multiple of cacheSize(elem) and not a power of two
- */
-template<typename elem>
-size_t calcPadSize(size_t size){
-	// add to make it multiple of cache line (padding)
-	size = alignUp(size, cacheSize(elem));
-	// make sure size is not a power of two, avoid cache trashing
-	size_t cacheLinesMem = size/cacheSize(elem);
-	if(cacheLinesMem >= L1LINE_N && isPowerOfTwo(cacheLinesMem))
-		size += cacheSize(elem);
-	return size;
-}
-
 /**
  * @brief Vectorized array, use this to use Vector Extensions easily	\n
  * Uses dynamic allocated aligned memory. The start of the array is 64 bytes aligned	\n